@@ -8,62 +8,586 @@
  * Program description: This program must follow conways rules and run the game of life. This means there must be a way of visualising the game board. The user should be able to pick a starting grid from a set of predefined boards, or create their own board of variable size.
  */
 
+//posix_memalign(), usleep(), mkstemp() and MAP_ANONYMOUS are POSIX and BSD additions that a strict -std=c11 build hides unless they are asked for.
+#define _DEFAULT_SOURCE
+
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
-
-
-//This is a structure that contains all the variables to do with the board, and the running of the game.
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//The board is bit-packed: each cell is one bit and 64 cells share a word. Every row is padded out to a whole number of 64 byte blocks so each row starts on its own cache line.
+#define WORD_BITS 64
+#define ROW_ALIGN_WORDS 8
+#define MAX_DIMENSION 1048576
+
+//The board is stepped in tiles of TILE_ROWS rows by TILE_WORDS words (64 by 512 cells). Tiles are the unit of work handed to the threads, and a tile with no live cells in or around it is not stepped at all.
+#define TILE_ROWS 64
+#define TILE_WORDS 8
+
+//A barrier that the threads in a pool all wait at until every one of them has arrived. It is made from a mutex and a condition variable rather than pthread_barrier_t, which some systems (macOS) don't have. phase counts how many times the barrier has opened, so a thread that wakes up early can tell it hasn't opened yet.
+typedef struct barrier {
+    pthread_mutex_t lock;
+    pthread_cond_t opened;
+    int count;
+    int waiting;
+    unsigned long phase;
+} Barrier;
+
+//A double-ended queue of tile numbers, one per thread. The owner takes tiles from the bottom end and other threads that have run out of work steal from the top end. All the tiles for a generation are put in before the threads start, so the queue only ever shrinks while it is in use, and the only race (for the last tile) is settled with a compare-and-swap on top. Each queue sits on its own cache line.
+typedef struct deque {
+    _Alignas(64) atomic_long top;
+    atomic_long bottom;
+    int *items;
+} Deque;
+
+//A pool of worker threads that are started once and then reused for every generation. The thread that calls pool_run() takes part as thread 0, so a pool of n threads only starts n-1 workers. Each run goes through two barriers: start hands the job to the workers and finish waits until they have all done their part. Each thread also has its own work-stealing queue of tiles.
+typedef struct worker {
+    struct thread_pool *pool;
+    int id;
+    pthread_t thread;
+} Worker;
+
+typedef struct thread_pool {
+    int threads;
+    Worker *workers;
+    Barrier start;
+    Barrier finish;
+    void (*job)(void *arg, int id, int threads);
+    void *arg;
+    int quit;
+    Deque *deques;
+} Thread_pool;
+
+//The sparse engine stores an unbounded plane as chunks of CHUNK_SIZE by CHUNK_SIZE cells, each row of a chunk being one word. Only chunks with live cells in them (and, during a step, the chunks next to them that live cells could spread into) are kept, so the memory used follows the population rather than the area the pattern covers.
+#define CHUNK_SIZE 64
+
+//A chunk of the plane, at chunk row cl and chunk column cw (the top left cell is at (cl*CHUNK_SIZE, cw*CHUNK_SIZE)). rows holds two generations, the current one picked by the plane's current. around holds the eight chunks next to it (or NULL where there isn't one), in the order NW, N, NE, W, E, SW, S, SE, and is filled in at the start of each step. chain links chunks in the same hash bucket and index is where the chunk is in the plane's list.
+typedef struct chunk {
+    int64_t cl;
+    int64_t cw;
+    uint64_t rows[2][CHUNK_SIZE];
+    struct chunk *around[8];
+    struct chunk *chain;
+    size_t index;
+    uint64_t alive;
+    uint64_t changed;
+} Chunk;
+
+//An unbounded plane of chunks, found by their position through a chained hash table and also kept in a list so they can be stepped in turn. changed is set if any cell changed in the last step.
+typedef struct sparse {
+    Chunk **buckets;
+    size_t bucket_count;
+    Chunk **chunks;
+    size_t count;
+    size_t capacity;
+    int current;
+    int changed;
+    uint64_t generation;
+} Sparse;
+
+//The births and deaths one thread has counted so far in a generation, padded out to a cache line so that no two threads write to the same line.
+typedef struct stat_partial {
+    uint64_t births;
+    uint64_t deaths;
+    char padding[48];
+} Stat_partial;
+
+//Statistics of the board, counted by the threads while they step it rather than by going over the board again. Once next() has run, population is the number of live cells in next_grid, births and deaths are the cells that came alive and died in that generation, and box holds the top and left and the bottom and right of the live cells (all -1 if there are none). Each thread adds its births and deaths into its own partial, and the partials are added up once every tile has been stepped. The population and box are put together from tile_population and tile_box, the count and box (4 numbers) of each tile from the last time it was stepped: a tile that is skipped either didn't change or is dead, so they still hold for it. written is the box last written to a time series, which is stored as the change from it.
+typedef struct board_stats {
+    uint64_t population;
+    uint64_t births;
+    uint64_t deaths;
+    int box[4];
+    int written[4];
+    uint32_t *tile_population;
+    int *tile_box;
+    int tiles;
+    Stat_partial *partials;
+    int threads;
+} Board_stats;
+
+//This is a structure that contains all the variables to do with the board, and the running of the game. Both boards are single contiguous, cache line aligned blocks of len*stride words sized from the board dimensions, and bits past the width of a row are always kept at zero. capacity is how many words each block can hold before it has to be allocated again.
+//The board is also split into tiles_down by tiles_across tiles. live and next_live have a flag for each tile of grid and next_grid that is set if any cell in that tile is alive, and changed and next_changed have a flag that is set if the tile changed in the generation that made that board. All four sets of flags share the one block tile_flags, and are swapped along with the boards each generation. active is the list of the active_count tiles stepped this generation. tiles_known is 0 when cells have been put into grid directly (by a loader) so the tile flags can't be trusted yet. If plane is set, the game is being run on that unbounded plane instead and the board is only a window onto it. If stats is set, next() counts the statistics in it as it steps the board. generation counts the generations since the board was loaded. When a board has been loaded from a snapshot, the boards are mapped into memory rather than allocated, and mapping holds the mapped regions so they can be unmapped rather than freed.
 typedef struct grid_info {
     int len;
     int wid;
-    int **grid;
-    int **next_grid;
+    size_t stride;
+    size_t capacity;
+    uint64_t *grid;
+    uint64_t *next_grid;
+    Thread_pool *pool;
+    int tiles_down;
+    int tiles_across;
+    int tile_capacity;
+    unsigned char *tile_flags;
+    unsigned char *live;
+    unsigned char *next_live;
+    unsigned char *changed;
+    unsigned char *next_changed;
+    int *active;
+    int active_count;
+    int tiles_known;
+    Sparse *plane;
+    Board_stats *stats;
+    uint64_t generation;
+    void *mapping[2];
+    size_t mapping_bytes[2];
 } Grid_info ;
 
+//The header at the start of a binary snapshot. In an uncompressed snapshot (version SNAPSHOT_VERSION) the header takes up the whole first SNAPSHOT_HEADER bytes of the file (one page), and the rows follow exactly as they are laid out in memory: len rows of stride words, bit-packed and padded to a cache line. This means the rows start on a page boundary and a snapshot can be mapped straight in as the board. Numbers are stored in the byte order of the machine that wrote the file.
+#define SNAPSHOT_HEADER 4096
+#define SNAPSHOT_VERSION 1
+
+typedef struct snapshot_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_bytes;
+    int32_t len;
+    int32_t wid;
+    uint64_t stride;
+    uint64_t generation;
+    char rule[32];
+} Snapshot_header;
+
+//Snapshots of version SNAPSHOT_PACKED are compressed instead, for boards that are mostly empty. The header is followed straight away by an index and then the blocks. The board is cut into blocks of BLOCK_ROWS rows by BLOCK_WORDS words (256 by 256 cells), numbered across and then down, and each block is compressed on its own (see pack_block()), so any block can be read without the others and the blocks can be packed and unpacked in parallel. The index holds one more offset than there are blocks, measured from the end of the index: block i takes up the bytes from offset i to offset i + 1.
+#define SNAPSHOT_PACKED 2
+#define BLOCK_ROWS 256
+#define BLOCK_WORDS 4
+#define BLOCK_BOUND (1 + BLOCK_ROWS * BLOCK_WORDS * sizeof(uint64_t) + 32)
+
+//The work shared between the threads packing or unpacking the blocks of a snapshot. data holds the blocks, at BLOCK_BOUND bytes apart while packing and at the offsets from the index while unpacking, sizes gets the size of each packed block, and failed is set if a block doesn't unpack to exactly its cells.
+typedef struct pack_job {
+    Grid_info *g;
+    unsigned char *data;
+    size_t data_bytes;
+    uint64_t *offsets;
+    size_t *sizes;
+    int blocks_across;
+    int blocks;
+    atomic_int failed;
+} Pack_job;
+
+//A board being copied by the threads, words words from from to to, each thread taking its own run of the words.
+typedef struct copy_job {
+    uint64_t *to;
+    const uint64_t *from;
+    size_t words;
+} Copy_job;
+
+//Cycle detection. Each generation of the board is boiled down to a 64 bit hash, and the hashes of the last CYCLE_HISTORY generations are kept so that a board that has settled into repeating itself with any period up to that many generations can be stopped. The hash of a board is the XOR of a mixed value for every word that isn't empty, made from the word and where it is, so when a generation only changes a few words the hash can be brought up to date from just those words (like Zobrist hashing, a word at a time instead of a cell at a time).
+#define CYCLE_HISTORY 1024
+
+//The hashes of the last size generations. ring holds them in order of generation (generation n at n % size), and the table (keys and generations, slots long, a power of two) finds a hash in the ring without searching it: it is an open addressing table with linear probing, where an empty slot has the generation UINT64_MAX. hash is the hash of the board as it is now.
+typedef struct history {
+    uint64_t *ring;
+    uint64_t *keys;
+    uint64_t *generations;
+    size_t size;
+    size_t slots;
+    uint64_t first;
+    uint64_t count;
+    uint64_t hash;
+} History;
+
+//A xoshiro256** random number generator, for filling soups. Each soup has one of its own, seeded from the soup's number through splitmix64, so a soup comes out the same whichever thread runs it, and the threads don't share any state the way they would with rand().
+typedef struct rng {
+    uint64_t s[4];
+} Rng;
+
+//What happened to one soup: the generation it settled into a cycle at (or the generation it was stopped at if it never did), the period of the cycle (1 for a still life or an empty board, 0 if it never settled), and its population at the end.
+typedef struct soup_result {
+    uint32_t lifespan;
+    uint32_t period;
+    uint32_t population;
+} Soup_result;
+
+//Up to 64 boards of the same size, stepped together in lockstep, one board to each bit of a word: cell (l, w) of board b is bit b of word (l + 1) * stride + w + 1 of cells, so one word holds the same cell of every board. Each row has a ghost cell at either end and there is a ghost row above and below, holding copies of the cells from the other side of the boards, so every board wraps round like the main board does. next_cells is the generation being worked out and before is the one before cells, kept to spot boards that have gone into a cycle of period 2.
+//running has a bit set for each board still running. A board stops when it comes back to where it was one or two generations before (a still life or an empty board, or a cycle of period 2) and is kept as it was from then on. lifespan and period say what happened to each board, in the same way as a Soup_result. Boards that can only settle into longer cycles run on until they are stopped from outside, and stopped tells how many generations ago the last board stopped.
+typedef struct lockstep {
+    int len;
+    int wid;
+    size_t stride;
+    uint64_t *cells;
+    uint64_t *next_cells;
+    uint64_t *before;
+    uint64_t running;
+    uint64_t generation;
+    uint64_t stopped;
+    uint32_t lifespan[64];
+    uint32_t period[64];
+} Lockstep;
+
+//The number of generations a lockstep soup search goes on for without any board stopping before it hands the boards still running over to be run one at a time (see soup_run_lockstep()).
+#define LOCKSTEP_PATIENCE 256
+
+//A search through count soups: random squares of size by size cells, numbered from seed, each put in the middle of an otherwise empty board of board by board cells and run until it settles into a cycle or reaches generation limit. The threads take the soups a block at a time from next, and each runs its soups one after another on a board of its own, or, if lockstep is set, runs each block of 64 soups together on a Lockstep. results has one result for each soup, in order of number.
+typedef struct soup_search {
+    long count;
+    uint64_t seed;
+    int size;
+    int board;
+    uint64_t limit;
+    int lockstep;
+    atomic_long next;
+    atomic_int failed;
+    Soup_result *results;
+} Soup_search;
+
+//A background thread that writes checkpoints while the board keeps being stepped. When a checkpoint is due, the board is copied into board (which is much quicker than writing it out) and the thread is woken to write the copy as a compressed snapshot. The snapshot is written to a temporary file that is then renamed over path, so path always holds the last complete checkpoint even if the program is stopped part way through a write. If a checkpoint falls due while the last one is still being written, it is skipped rather than waiting. copy describes the board being written, and busy is set from when a copy is handed over until it has been written.
+typedef struct checkpointer {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    const char *path;
+    Grid_info copy;
+    size_t capacity;
+    int busy;
+    int quit;
+    int written;
+    int skipped;
+    int failed;
+} Checkpointer;
+
+//The fast terminal renderer. It shows a window of the board with the cell at (top, left) in the top left corner of the screen, rows by columns characters in size. With zoom set to 1 each character is a Unicode braille glyph showing 2 by 4 cells exactly. With a larger zoom each character shows a block of zoom by 2*zoom cells as a shade of how many of them are alive, worked out from a fixed number of sampled cells, so a huge board costs no more to draw than a small one. The frame is built up in buffer and sent with one write(), and only the rows of characters that are different from what is already on screen (kept in shown, one byte per character) are redrawn, with ANSI codes moving the cursor to each one. glyphs is room for working out the next frame. drawn is 0 until the first frame has cleared the screen.
+typedef struct renderer {
+    char *buffer;
+    size_t capacity;
+    unsigned char *shown;
+    unsigned char *glyphs;
+    int rows;
+    int columns;
+    int top;
+    int left;
+    int zoom;
+    int drawn;
+} Renderer;
+
+//A single-producer, single-consumer ring of frames, passed from the thread stepping the board to the thread drawing it without any locks. Each slot holds the characters of one frame (as worked out by render_glyphs()) and the generation it shows. The producer only writes head and the consumer only writes tail, each on its own cache line: a slot is full from when head moves past it until tail does. The consumer sets wanted when it is ready to draw, and the producer only samples the board once it sees it set, so the frame drawn is the board as it is at that moment rather than one sampled a frame earlier, and a slow terminal never holds up the board. If more than one frame has come through, the consumer draws the newest and drops the others.
+#define RING_SLOTS 4
+
+typedef struct frame_ring {
+    _Alignas(64) atomic_size_t head;
+    _Alignas(64) atomic_size_t tail;
+    _Alignas(64) atomic_int wanted;
+    unsigned char *slots;
+    size_t slot_bytes;
+    uint64_t generation[RING_SLOTS];
+} Frame_ring;
+
+//A live view of a running board: a renderer on its own thread, fed through a frame ring. drawn counts the frames shown and skipped the generations between them that were never shown (both only written by the view thread), shown is the generation of the last frame drawn, and quit tells the thread to stop once the ring is empty.
+typedef struct live_view {
+    Renderer renderer;
+    Frame_ring ring;
+    pthread_t thread;
+    atomic_int quit;
+    int fps;
+    long drawn;
+    long skipped;
+    uint64_t shown;
+} Live_view;
+
+//Frame export. Generations are written out as images: one PBM (black and white) or PGM (grey, with live cells white) file per frame, or a raw stream of 8 bit grey frames with no headers that can be piped straight into a video encoder. Each cell is drawn as zoom by zoom pixels.
+#define EXPORT_PBM 0
+#define EXPORT_PGM 1
+#define EXPORT_RAW 2
+
+//One frame waiting to be, or being, encoded: a copy of the board, its generation and its place in the sequence of frames. image holds the encoded frame for a raw stream, which has to be written out in order. state is 0 when the slot is free, 1 when the frame is waiting for a worker, 2 while it is being encoded and 3 when a raw frame is encoded and waiting its turn to be written.
+typedef struct export_job {
+    uint64_t *board;
+    unsigned char *image;
+    uint64_t generation;
+    long sequence;
+    int state;
+} Export_job;
+
+//A pool of threads that encode frames away from the thread stepping the board. The stepping thread copies the board into a free slot and carries on, and waits only if every slot is full. Frames for files are written by the worker that encoded them, in any order. Raw frames are written in order: a worker that finishes a frame writes out every frame that is ready from next_write on, and writing stops another worker doing the same at the same time.
+//spread holds the eight grey pixels for each byte of cells, so whole bytes of the board can be encoded at once.
+typedef struct exporter {
+    const char *pattern;
+    FILE *stream;
+    int format;
+    int zoom;
+    int len;
+    int wid;
+    size_t stride;
+    Export_job *jobs;
+    int slots;
+    pthread_t *threads;
+    int thread_count;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t space;
+    long next_sequence;
+    long next_write;
+    int writing;
+    int quit;
+    long frames;
+    int failed;
+    unsigned char spread[256][8];
+} Exporter;
+
+
+//A node of the HashLife quadtree: a square of 2^level by 2^level cells made of four quarters one level down. Level 0 nodes are single cells, and there are only two of them (alive and dead). Every other node is stored once in a hash table keyed on its four quarters, so identical squares anywhere in the pattern or at any time share one node. result is the centre of the node (one level down) after 2^step generations, worked out the first time it is needed and then remembered.
+typedef struct node {
+    struct node *nw;
+    struct node *ne;
+    struct node *sw;
+    struct node *se;
+    struct node *result;
+    struct node *chain;
+    uint64_t population;
+    int level;
+    int marked;
+} Node;
+
+#define HL_MAX_LEVEL 62
+//The largest k that hl_advance() can step 2^k generations: the root has to reach level k+2 and then take one more border, all below HL_MAX_LEVEL-1.
+#define HL_MAX_JUMP (HL_MAX_LEVEL - 4)
+#define HL_BLOCK_NODES 4096
+
+//The HashLife universe. The pattern lives on an unbounded plane rather than a torus: root covers it with its top left cell at (origin_l, origin_w) in board coordinates. node_limit is the number of nodes kept before garbage collection starts, and stack holds the nodes that recursive calls are still working on so the collector doesn't free them. Nodes are handed out from blocks of HL_BLOCK_NODES and freed nodes go on free_nodes.
+typedef struct hashlife {
+    Node **buckets;
+    size_t bucket_count;
+    size_t nodes;
+    size_t node_limit;
+    size_t gc_at;
+    Node *free_nodes;
+    Node **blocks;
+    int block_count;
+    Node leaf[2];
+    Node *empty[HL_MAX_LEVEL + 1];
+    Node *root;
+    int64_t origin_l;
+    int64_t origin_w;
+    int step;
+    uint64_t generation;
+    Node *stack[HL_MAX_LEVEL * 16];
+    int depth;
+} Hashlife;
+
+//What a row kernel found out about the words it wrote: alive has a bit set if any of them has a live cell, and changed has a bit set if any cell is different from the generation before.
+typedef struct row_result {
+    uint64_t alive;
+    uint64_t changed;
+} Row_result;
+
+//The row kernel used by next(). It steps words first to end-1 of one row. It points at the plain 64 bit version until select_kernel() finds out which vector instructions the processor has.
+typedef Row_result (*Row_kernel)(const uint64_t *up, const uint64_t *mid, const uint64_t *down, uint64_t *out, size_t first, size_t end, int wid);
+Row_kernel step_row;
+const char *kernel_name;
+
+//The counter used by step_tile() when statistics are being counted. It counts the live cells, births and deaths in words first to end-1 of one row (before and after a generation) into counts, and ORs the words after into columns. select_kernel() points it at a version using the processor's popcount instruction if it has one.
+typedef void (*Row_counter)(const uint64_t *before, const uint64_t *after, size_t first, size_t end, uint64_t counts[3], uint64_t *columns);
+Row_counter count_row;
+
+//The lockstep kernel used by lockstep_step() (see Lockstep). It steps cells 1 to wid of one row of 64 boards at once, keeping the boards that have stopped (those without a bit in running) as they were. found[0] gets a bit set for each board where any cell changed, and found[1] for each board where any cell is different from the generation before. It is picked by select_kernel() along with step_row.
+typedef void (*Lockstep_kernel)(const uint64_t *up, const uint64_t *mid, const uint64_t *down, const uint64_t *before, uint64_t *out, int wid, uint64_t running, uint64_t found[2]);
+Lockstep_kernel step_lockstep;
+
+//The kinds of rule that have row kernels of their own. Any other rule runs on the generic kernels, which look the rule up as they go.
+#define RULE_CONWAY 0
+#define RULE_HIGHLIFE 1
+#define RULE_DAY_NIGHT 2
+#define RULE_SEEDS 3
+#define RULE_GENERIC 4
+#define RULE_KINDS 5
+
+//A Life-like rule in B/S notation, such as B3/S23 for Conway's Game of Life. born has bit n set if a dead cell with n live neighbours comes alive, and survive has bit n set if a live cell with n live neighbours stays alive. table holds the same thing as a lookup table of the next state, indexed by the state of the cell and then its number of live neighbours. name is the rule written out in B/S notation, and kind picks its row kernels.
+typedef struct rule {
+    char name[32];
+    uint16_t born;
+    uint16_t survive;
+    unsigned char table[2][9];
+    int kind;
+} Rule;
+
+//The rule every board is stepped with. It is Conway's unless set_rule() is given another one.
+Rule life_rule;
+
 //==================== Function Definitions ==============
 
 int input(int min, int max);
+size_t row_stride(int wid);
+int grid_alloc(Grid_info *g, int len, int wid);
+int grid_resize(Grid_info *g, int len, int wid);
+void grid_free(Grid_info *g);
+int load_text(Grid_info *g, const char *path);
+int cell(Grid_info *g, int l, int w);
+void set_cell(uint64_t *board, size_t stride, int l, int w, int value);
 int alive_or_dead(int n, int alive_neighbours);
+void next_scalar(Grid_info *g);
+Row_result step_row_swar(const uint64_t *up, const uint64_t *mid, const uint64_t *down, uint64_t *out, size_t first, size_t end, int wid);
+void select_kernel(void);
+int parse_rule(Rule *rule, const char *text);
+int set_rule(const char *text);
+void barrier_init(Barrier *b, int count);
+void barrier_wait(Barrier *b);
+void barrier_destroy(Barrier *b);
+Thread_pool *pool_create(int threads);
+void pool_run(Thread_pool *pool, void (*job)(void *arg, int id, int threads), void *arg);
+void pool_destroy(Thread_pool *pool);
+int thread_count(void);
+int deque_take(Deque *d);
+int deque_steal(Deque *d);
+void step_tile(Grid_info *g, int tile, int id);
+void step_tiles(void *arg, int id, int threads);
+int render_init(Renderer *r, Grid_info *g, int top, int left, int zoom);
+void render_free(Renderer *r);
+void render_glyphs(const Renderer *r, Grid_info *g, unsigned char *glyphs);
+size_t render_encode(Renderer *r, const unsigned char *glyphs);
+size_t render_frame(Renderer *r, Grid_info *g);
+void render_write(Renderer *r, size_t size);
+void render_draw(Renderer *r, Grid_info *g);
+int frames_per_second(void);
+int view_start(Live_view *v, Grid_info *g, int top, int left, int zoom);
+void view_offer(Live_view *v, Grid_info *g, int wait);
+void view_stop(Live_view *v, Grid_info *g);
 void next(Grid_info *g);
+void advance(Grid_info *g);
+int board_changed(Grid_info *g);
+uint64_t board_hash(Grid_info *g, const uint64_t *board);
+uint64_t hash_update(Grid_info *g, uint64_t hash);
+int history_init(History *h, size_t size);
+void history_free(History *h);
+void history_start(History *h, Grid_info *g);
+uint64_t history_add(History *h, uint64_t hash, uint64_t generation);
+uint64_t history_step(History *h, Grid_info *g, uint64_t *start);
+int stats_init(Board_stats *s, Grid_info *g);
+void stats_free(Board_stats *s, Grid_info *g);
+void stats_gather(Board_stats *s, Grid_info *g);
 void custom(Grid_info *g);
 void print_board(Grid_info *g);
 void equal_grids(Grid_info *g, int array1[g->len][g->wid]);
 void run(int iterations, Grid_info *g);
-void preset(Grid_info *g);
+int preset(Grid_info *g);
+int save_text(Grid_info *g, const char *path);
+int load_rle(Grid_info *g, const char *path);
+int save_rle(Grid_info *g, const char *path);
+int save_snapshot(Grid_info *g, const char *path);
+int save_packed(Grid_info *g, const char *path);
+int load_snapshot(Grid_info *g, const char *path);
+void delta_start(FILE *file, Grid_info *g);
+void delta_frame(FILE *file, Grid_info *g, const uint64_t *before, const uint64_t *after, int use_tiles);
+int replay(int argc, char *argv[]);
+void stats_start(FILE *file, Grid_info *g);
+void stats_record(FILE *file, Board_stats *s);
+int statistics(int argc, char *argv[]);
+void frame_name(char *name, size_t size, const char *pattern, uint64_t generation);
+int export_threads(int stepping);
+int export_start(Exporter *e, Grid_info *g, const char *pattern, int zoom, int threads);
+void export_frame(Exporter *e, Grid_info *g);
+int export_finish(Exporter *e);
+int load_board(Grid_info *g, const char *path);
+int save_board(Grid_info *g, const char *path);
+int hl_init(Hashlife *hl, size_t node_limit);
+void hl_free(Hashlife *hl);
+Node *hl_join(Hashlife *hl, Node *nw, Node *ne, Node *sw, Node *se);
+Node *hl_empty(Hashlife *hl, int level);
+void hl_gc(Hashlife *hl, int drop_results);
+Node *hl_successor(Hashlife *hl, Node *n);
+void hl_load(Hashlife *hl, Grid_info *g);
+void hl_store(Hashlife *hl, Grid_info *g);
+int hl_advance(Hashlife *hl, int k);
+size_t hashlife_nodes(void);
+int sparse_init(Sparse *s);
+void sparse_free(Sparse *s);
+Chunk *sparse_chunk(Sparse *s, int64_t cl, int64_t cw, int make);
+void sparse_set(Sparse *s, int64_t l, int64_t w, int value);
+void sparse_step(Sparse *s, Thread_pool *pool);
+uint64_t sparse_population(const Sparse *s);
+void sparse_load(Sparse *s, Grid_info *g);
+void sparse_view(const Sparse *s, Grid_info *g, uint64_t *board);
+void fast_forward(Grid_info *g);
+uint64_t population(Grid_info *g);
+int checkpoint_start(Checkpointer *c, const char *path);
+void checkpoint_offer(Checkpointer *c, Grid_info *g, int wait);
+void checkpoint_stop(Checkpointer *c);
+int batch(int argc, char *argv[]);
+void rng_seed(Rng *r, uint64_t seed);
+uint64_t rng_next(Rng *r);
+void soup_fill(Grid_info *g, Rng *r, int size);
+int lockstep_init(Lockstep *k, int len, int wid);
+void lockstep_free(Lockstep *k);
+void lockstep_clear(Lockstep *k);
+void lockstep_set(Lockstep *k, int board, int l, int w, int value);
+int lockstep_cell(const Lockstep *k, int board, int l, int w);
+void lockstep_start(Lockstep *k, int boards);
+void lockstep_step(Lockstep *k);
+void lockstep_run(Lockstep *k, uint64_t limit, uint64_t patience);
+void lockstep_population(const Lockstep *k, uint32_t counts[64]);
+void lockstep_fill(Lockstep *k, int board, Rng *r, int size);
+int lockstep_copy(const Lockstep *k, int board, Grid_info *g);
+void soup_settle(Grid_info *g, History *h, uint64_t limit, Soup_result *result);
+void soup_run(void *arg, int id, int threads);
+void soup_run_lockstep(void *arg, int id, int threads);
+int soup_search(Soup_search *search, Thread_pool *pool);
+int soup(int argc, char *argv[]);
+void randomise(Grid_info *g);
+double now_seconds(void);
+void scatter_soups(Grid_info *g, int soups, int size);
+int check_kernel(Grid_info *a, Grid_info *b, int generations);
+int check_rules(Thread_pool *pool, int size, int generations);
+int check_cycles(Thread_pool *pool);
+int check_stats(Thread_pool *pool, int size, int generations);
+int check_soups(Thread_pool *pool);
+int check_lockstep(void);
+int time_threads(Grid_info *a, int generations, int advancing);
+uint64_t check_hashlife(Thread_pool *pool);
+uint64_t check_sparse(Thread_pool *pool);
+int check_packed(Thread_pool *pool);
+int check_rle(void);
+void time_render(Thread_pool *pool);
+void time_export(Thread_pool *pool);
+int benchmark(int argc, char *argv[]);
 
 
 //======================= Main Program =========================
 
-int main(){
+int main(int argc, char *argv[]){
     Grid_info g;
-    g.len = 40;
-    g.wid = 40;
+    //Every board is stepped with Conway's rules unless GOL_RULE gives another Life-like rule in B/S notation.
+    const char *rule = getenv("GOL_RULE");
+    if (rule == NULL || set_rule(rule) != 0) {
+        set_rule("B3/S23");
+    }
     
-    //Memory allocation for grid and next grid in the structure. Max dimensions for the game board in this program is 40x40.
-    g.grid = (int **)malloc(40*sizeof(int*));
-    if (g.grid == NULL) {
-        printf("Out of memory!\n");
-        return -1;
+    //Running the program as "game bench" times the stepping kernels instead of starting the menu, "game batch" runs a board from a file with no menu or printing, "game replay" turns a delta stream back into boards, "game stats" prints a time series of statistics, and "game soup" searches through random soups.
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        return benchmark(argc, argv);
     }
-    for(int l = 0; l<g.len; l++){
-        g.grid[l] = (int *)malloc(40*sizeof(int));
-        if (g.grid[l] == NULL) {
-            printf("Out of memory!\n");
-            return -1;
-        }
+    if (argc > 1 && strcmp(argv[1], "batch") == 0) {
+        return batch(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "replay") == 0) {
+        return replay(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "stats") == 0) {
+        return statistics(argc, argv);
     }
-    g.next_grid = (int **)malloc(40*sizeof(int*));
-    if (g.next_grid == NULL) {
+    if (argc > 1 && strcmp(argv[1], "soup") == 0) {
+        return soup(argc, argv);
+    }
+    
+    //Memory allocation for grid and next grid in the structure. The boards are allocated again whenever a bigger board is chosen, so this is only the starting size.
+    if (grid_alloc(&g, 40, 40) != 0) {
         printf("Out of memory!\n");
         return -1;
     }
-    for(int l = 0; l<g.len; l++){
-        g.next_grid[l] = (int *)malloc(40*sizeof(int));
-        if (g.next_grid[l] == NULL) {
-            printf("Out of memory!\n");
-            return -1;
-        }
+    //The worker threads are started once here and reused for every generation.
+    g.pool = pool_create(thread_count());
+    if (g.pool == NULL) {
+        printf("Could not start the worker threads!\n");
+        return -1;
     }
     
 //Start of menu
@@ -72,11 +596,15 @@ int main(){
         printf("Menu:\n");
         printf("Press 1 to start the game from a set of pre-defined configurations\n");
         printf("Press 2 to set a custom board\n");
-        printf("Press 3 to exit\n");
-        choice = input(1,3);
+        printf("Press 3 to jump a pre-defined configuration far ahead with HashLife\n");
+        printf("Press 4 to run a pre-defined configuration on an unbounded plane\n");
+        printf("Press 5 to exit\n");
+        choice = input(1,5);
         switch (choice) {
             case 1: {
-                preset(&g);
+                if (preset(&g) != 0) {
+                    break;
+                }
                 printf("How many repeats do you want the game to do? (max 200)\n");
                 iterations = input(1,200);
                 run(iterations, &g);
@@ -84,9 +612,13 @@ int main(){
             }
             case 2: {
                 printf("Please enter the length of your custom board:\n");
-                g.len = input(1,40);
+                int len = input(1,MAX_DIMENSION);
                 printf("Please enter the width of your custom board:\n");
-                g.wid = input(1,40);
+                int wid = input(1,MAX_DIMENSION);
+                if (grid_resize(&g, len, wid) != 0) {
+                    printf("Out of memory!\n");
+                    break;
+                }
                 printf("The custom board size is %d by %d\n",g.len,g.wid);
                 custom(&g);
                 printf("How many repeats do you want the game to do? (max 200)\n");
@@ -95,6 +627,32 @@ int main(){
                 break;
             }
             case 3: {
+                if (preset(&g) != 0) {
+                    break;
+                }
+                fast_forward(&g);
+                break;
+            }
+            case 4: {
+                Sparse plane;
+                if (preset(&g) != 0) {
+                    break;
+                }
+                if (sparse_init(&plane) != 0) {
+                    printf("Out of memory!\n");
+                    break;
+                }
+                sparse_load(&plane, &g);
+                g.plane = &plane;
+                printf("How many repeats do you want the game to do? (max 200)\n");
+                iterations = input(1,200);
+                run(iterations, &g);
+                printf("Generation %llu, population %llu in %zu chunks\n", (unsigned long long)plane.generation, (unsigned long long)sparse_population(&plane), plane.count);
+                g.plane = NULL;
+                sparse_free(&plane);
+                break;
+            }
+            case 5: {
                 printf("Thank you for using this code.\n");
                 repeat=0;
                 break;
@@ -103,13 +661,15 @@ int main(){
                 printf("You were meant to enter an integer between 1 and 4. Please try again.\n");
         }
     }
+    grid_free(&g);
+    pool_destroy(g.pool);
     return 0;
 }
 
 
 //========================= Functions =======================
 
-//An input function with a check on the user input is useful in this code. All the inputs needed from the user in this program are integers, but vary with the limits depending on the situation. For example, the input for a custom grid is either 0 or 1, but the input for the grid length can go from 1 to 40.
+//An input function with a check on the user input is useful in this code. All the inputs needed from the user in this program are integers, but vary with the limits depending on the situation. For example, the input for a custom grid is either 0 or 1, but the input for the grid length can go from 1 to MAX_DIMENSION.
 int input(int min, int max){
     int x, repeat=1;
     scanf("%i", &x);
@@ -125,13 +685,163 @@ int input(int min, int max){
     return x;
 }
 
+//Works out how many 64 bit words are needed for each row of a board that is wid cells wide. The count is rounded up to a whole cache line so that rows never share a line.
+size_t row_stride(int wid){
+    size_t words = ((size_t)wid + WORD_BITS - 1) / WORD_BITS;
+    return (words + ROW_ALIGN_WORDS - 1) / ROW_ALIGN_WORDS * ROW_ALIGN_WORDS;
+}
+
+//This function sets up an empty structure and allocates a board of len by wid cells. It returns -1 if the memory could not be found.
+int grid_alloc(Grid_info *g, int len, int wid){
+    g->pool = NULL;
+    g->plane = NULL;
+    g->stats = NULL;
+    g->capacity = 0;
+    g->grid = NULL;
+    g->next_grid = NULL;
+    g->tile_capacity = 0;
+    g->tile_flags = NULL;
+    g->active = NULL;
+    g->mapping[0] = NULL;
+    g->mapping[1] = NULL;
+    return grid_resize(g, len, wid);
+}
+
+//Gives back the memory of both boards, unmapping them if they were mapped from a snapshot and freeing them otherwise.
+static void board_release(Grid_info *g){
+    uint64_t *boards[2] = {g->grid, g->next_grid};
+    for(int b=0; b<2; b++){
+        int mapped = 0;
+        for(int i=0; i<2; i++){
+            char *start = (char *)g->mapping[i];
+            mapped |= (start != NULL && (char *)boards[b] >= start && (char *)boards[b] < start + g->mapping_bytes[i]);
+        }
+        if (mapped == 0) {
+            free(boards[b]);
+        }
+    }
+    for(int i=0; i<2; i++){
+        if (g->mapping[i] != NULL) {
+            munmap(g->mapping[i], g->mapping_bytes[i]);
+        }
+        g->mapping[i] = NULL;
+    }
+    g->grid = NULL;
+    g->next_grid = NULL;
+    g->capacity = 0;
+}
+
+//Sets the size of the board and the tiles without touching the cells. If the board no longer fits in the memory that has already been allocated, both boards are allocated again as single blocks aligned to a cache line, sized from the new dimensions. It returns -1 if the size is out of range or the memory could not be found, and the board is then left exactly as it was.
+static int grid_shape(Grid_info *g, int len, int wid){
+    size_t stride = row_stride(wid);
+    size_t words = (size_t)len * stride;
+    int tiles_down = (len + TILE_ROWS - 1) / TILE_ROWS;
+    int tiles_across = (int)((((size_t)wid + WORD_BITS - 1) / WORD_BITS + TILE_WORDS - 1) / TILE_WORDS);
+    size_t tiles = (size_t)tiles_down * tiles_across;
+    
+    if (len < 1 || wid < 1 || len > MAX_DIMENSION || wid > MAX_DIMENSION) {
+        return -1;
+    }
+    //Anything that has to be allocated again is allocated before anything is given up, so if the memory can't be found the old board is left as it was. The four sets of tile flags share one block.
+    int new_tiles = (int)tiles > g->tile_capacity, new_boards = words > g->capacity;
+    unsigned char *tile_flags = NULL;
+    int *active = NULL;
+    void *grid = NULL, *next_grid = NULL;
+    if (new_tiles) {
+        tile_flags = (unsigned char *)malloc(4 * tiles);
+        active = (int *)malloc(tiles * sizeof(int));
+    }
+    if (new_boards) {
+        if (posix_memalign(&grid, ROW_ALIGN_WORDS * sizeof(uint64_t), words * sizeof(uint64_t)) != 0) {
+            grid = NULL;
+        }
+        if (posix_memalign(&next_grid, ROW_ALIGN_WORDS * sizeof(uint64_t), words * sizeof(uint64_t)) != 0) {
+            next_grid = NULL;
+        }
+    }
+    if ((new_tiles && (tile_flags == NULL || active == NULL)) || (new_boards && (grid == NULL || next_grid == NULL))) {
+        free(tile_flags);
+        free(active);
+        free(grid);
+        free(next_grid);
+        return -1;
+    }
+    if (new_tiles) {
+        free(g->tile_flags);
+        free(g->active);
+        g->tile_flags = tile_flags;
+        g->active = active;
+        g->tile_capacity = (int)tiles;
+    }
+    if (new_boards) {
+        board_release(g);
+        g->grid = (uint64_t *)grid;
+        g->next_grid = (uint64_t *)next_grid;
+        g->capacity = words;
+    }
+    g->live = g->tile_flags;
+    g->next_live = g->tile_flags + tiles;
+    g->changed = g->tile_flags + 2 * tiles;
+    g->next_changed = g->tile_flags + 3 * tiles;
+    g->len = len;
+    g->wid = wid;
+    g->stride = stride;
+    g->tiles_down = tiles_down;
+    g->tiles_across = tiles_across;
+    g->tiles_known = 0;
+    g->active_count = 0;
+    g->generation = 0;
+    memset(g->tile_flags, 0, 4 * tiles);
+    return 0;
+}
+
+//Changes the size of the board and clears every cell, so no bits from an earlier, wider board are left behind in the padding. A board mapped from a snapshot is always replaced by allocated memory, and is only given up once that has been found. It returns -1 if the size is out of range or the memory could not be found.
+int grid_resize(Grid_info *g, int len, int wid){
+    size_t capacity = g->capacity;
+    if (g->mapping[0] != NULL) {
+        g->capacity = 0;
+    }
+    if (grid_shape(g, len, wid) != 0) {
+        g->capacity = capacity;
+        return -1;
+    }
+    memset(g->grid, 0, (size_t)len * g->stride * sizeof(uint64_t));
+    memset(g->next_grid, 0, (size_t)len * g->stride * sizeof(uint64_t));
+    return 0;
+}
+
+//Frees both boards and the tile lists.
+void grid_free(Grid_info *g){
+    board_release(g);
+    free(g->tile_flags);
+    free(g->active);
+    g->tile_flags = NULL;
+    g->active = NULL;
+    g->tile_capacity = 0;
+}
+
+//Returns the state (0 or 1) of the cell at row l and column w of the current board.
+int cell(Grid_info *g, int l, int w){
+    return (int)((g->grid[(size_t)l * g->stride + (w / WORD_BITS)] >> (w % WORD_BITS)) & 1);
+}
+
+//Sets the cell at row l and column w of a bit-packed board to the value given (0 or 1).
+void set_cell(uint64_t *board, size_t stride, int l, int w, int value){
+    uint64_t bit = (uint64_t)1 << (w % WORD_BITS);
+    if(value == 1){
+        board[(size_t)l * stride + (w / WORD_BITS)] |= bit;
+    }else{
+        board[(size_t)l * stride + (w / WORD_BITS)] &= ~bit;
+    }
+}
+
 //This function prints a 2D array as a grid to the terminal screen. It goes through the whole 2D array in order printing a * where there are ones (alive) and a . where there are zeros (dead).
 void print_board(Grid_info *g){
     printf("\n");
     for (int l=0 ; l < g->len ; l++){
         printf("(");
         for (int w=0 ; w < g->wid ; w++){
-            if(g->grid[l][w]==1){
+            if(cell(g, l, w)==1){
                 printf(" * ");
             }else{
                 printf(" . ");
@@ -146,214 +856,4684 @@ void print_board(Grid_info *g){
 void equal_grids(Grid_info *g, int array[g->len][g->wid]){
     for(int l=0; l<g->len; l++){
         for(int w=0; w<g->wid; w++){
-            g->grid[l][w] = array[l][w];
+            set_cell(g->grid, g->stride, l, w, array[l][w]);
         }
     }
 }
 
-//This function determines the future of any cell (being 0 or 1) depending on how many alive neighbours it has. The rules for Conways Game of Life are that for a dead cell to become alive, it needs exactly 3 alive neighbours. An alive cell will die to overpopulation if there are 4 or more alive neighbours. An alive cell will die to solitude if it has one or zero alive neighbours. This if else statement implements these rules into the code. The input of n in this function can only be 0 or 1.
+//This function determines the future of any cell (being 0 or 1) depending on how many alive neighbours it has. The rules for Conways Game of Life are that for a dead cell to become alive, it needs exactly 3 alive neighbours. An alive cell will die to overpopulation if there are 4 or more alive neighbours. An alive cell will die to solitude if it has one or zero alive neighbours. Other Life-like rules just change which numbers of neighbours give birth and survival, so the answer is looked up in the table of the rule being run (see Rule) instead of being worked out with branches. The input of n in this function can only be 0 or 1.
 int alive_or_dead(int n, int alive_neighbours){
-    //Cell dies
-    if ((n == 1 && alive_neighbours < 2) || (n == 1 && alive_neighbours > 3)){
-        return 0;
-    }
-    //Cell is born
-    else if (n == 0 && alive_neighbours == 3){
-        return 1;
-    }
-    //No change to cell
-    else{
-        return n;
-    }
+    return life_rule.table[n][alive_neighbours];
 }
 
-//This function calculates the next grid based off conways rules and also the starting grid. Each cell has eight specific neighbours. It is complicated to code the neighbours of the cells at the boundaries of the grid, as the grid needs to loop around so the board is continuous.
-void next(Grid_info *g){
+//This function calculates the next grid based off conways rules and also the starting grid, one cell at a time. Each cell has eight specific neighbours. It is complicated to code the neighbours of the cells at the boundaries of the grid, as the grid needs to loop around so the board is continuous. It is kept as the reference that the faster word-at-a-time kernel is checked against.
+void next_scalar(Grid_info *g){
     int alive_neighbours;
     
     //MAIN INSIDE BLOCK
     for(int l=1; l+1<g->len; l++){
         for(int w=1; w+1<g->wid; w++){
-            alive_neighbours = g->grid[l-1][w-1] + g->grid[l-1][w] + g->grid[l-1][w+1] + g->grid[l][w-1] + g->grid[l][w+1] + g->grid[l+1][w-1] + g->grid[l+1][w] + g->grid[l+1][w+1];
-            g->next_grid[l][w] = alive_or_dead(g->grid[l][w], alive_neighbours);
+            alive_neighbours = cell(g, l-1, w-1) + cell(g, l-1, w) + cell(g, l-1, w+1) + cell(g, l, w-1) + cell(g, l, w+1) + cell(g, l+1, w-1) + cell(g, l+1, w) + cell(g, l+1, w+1);
+            set_cell(g->next_grid, g->stride, l, w, alive_or_dead(cell(g, l, w), alive_neighbours));
         }
     }
     //EDGES - Loops round one side
     //left
     for(int l=1; l+1<g->len; l++){
-        alive_neighbours = g->grid[l+1][1] + g->grid[l][1] + g->grid[l-1][1] + g->grid[l+1][0] + g->grid[l-1][0] + g->grid[l+1][g->wid-1] + g->grid[l][g->wid-1] + g->grid[l-1][g->wid-1];
-        g->next_grid[l][0] = alive_or_dead(g->grid[l][0], alive_neighbours);
+        alive_neighbours = cell(g, l+1, 1) + cell(g, l, 1) + cell(g, l-1, 1) + cell(g, l+1, 0) + cell(g, l-1, 0) + cell(g, l+1, g->wid-1) + cell(g, l, g->wid-1) + cell(g, l-1, g->wid-1);
+        set_cell(g->next_grid, g->stride, l, 0, alive_or_dead(cell(g, l, 0), alive_neighbours));
     }
     //right
     for(int l=1; l+1<g->len; l++){
-        alive_neighbours = g->grid[l+1][0] + g->grid[l][0] + g->grid[l-1][0] + g->grid[l+1][g->wid-1] + g->grid[l-1][g->wid-1] + g->grid[l+1][g->wid-2] + g->grid[l][g->wid-2] + g->grid[l-1][g->wid-2];
-        g->next_grid[l][g->wid-1] = alive_or_dead(g->grid[l][g->wid-1], alive_neighbours);
+        alive_neighbours = cell(g, l+1, 0) + cell(g, l, 0) + cell(g, l-1, 0) + cell(g, l+1, g->wid-1) + cell(g, l-1, g->wid-1) + cell(g, l+1, g->wid-2) + cell(g, l, g->wid-2) + cell(g, l-1, g->wid-2);
+        set_cell(g->next_grid, g->stride, l, g->wid-1, alive_or_dead(cell(g, l, g->wid-1), alive_neighbours));
     }
     //top
     for(int w=1; w+1<g->wid; w++){
-        alive_neighbours = g->grid[1][w+1] + g->grid[1][w] + g->grid[1][w-1] + g->grid[0][w+1] + g->grid[0][w-1] + g->grid[g->len-1][w+1] + g->grid[g->len-1][w] + g->grid[g->len-1][w-1];
-        g->next_grid[0][w] = alive_or_dead(g->grid[0][w], alive_neighbours);
+        alive_neighbours = cell(g, 1, w+1) + cell(g, 1, w) + cell(g, 1, w-1) + cell(g, 0, w+1) + cell(g, 0, w-1) + cell(g, g->len-1, w+1) + cell(g, g->len-1, w) + cell(g, g->len-1, w-1);
+        set_cell(g->next_grid, g->stride, 0, w, alive_or_dead(cell(g, 0, w), alive_neighbours));
     }
     //bottom
     for(int w=1; w+1<g->wid; w++){
-        alive_neighbours = g->grid[0][w+1] + g->grid[0][w] + g->grid[0][w-1] + g->grid[g->len-1][w+1] + g->grid[g->len-1][w-1] + g->grid[g->len-2][w+1] + g->grid[g->len-2][w] + g->grid[g->len-2][w-1];
-        g->next_grid[g->len-1][w] = alive_or_dead(g->grid[g->len-1][w], alive_neighbours);
+        alive_neighbours = cell(g, 0, w+1) + cell(g, 0, w) + cell(g, 0, w-1) + cell(g, g->len-1, w+1) + cell(g, g->len-1, w-1) + cell(g, g->len-2, w+1) + cell(g, g->len-2, w) + cell(g, g->len-2, w-1);
+        set_cell(g->next_grid, g->stride, g->len-1, w, alive_or_dead(cell(g, g->len-1, w), alive_neighbours));
     }
     //CORNERS - Loops round up to 3 sides
     //top left
-    alive_neighbours = g->grid[1][1] + g->grid[1][0] + g->grid[1][g->wid-1] + g->grid[0][1] + g->grid[0][g->wid-1] + g->grid[g->len-1][1] + g->grid[g->len-1][0] + g->grid[g->len-1][g->wid-1] ;
-    g->next_grid[0][0] = alive_or_dead(g->grid[0][0], alive_neighbours);
+    alive_neighbours = cell(g, 1, 1) + cell(g, 1, 0) + cell(g, 1, g->wid-1) + cell(g, 0, 1) + cell(g, 0, g->wid-1) + cell(g, g->len-1, 1) + cell(g, g->len-1, 0) + cell(g, g->len-1, g->wid-1) ;
+    set_cell(g->next_grid, g->stride, 0, 0, alive_or_dead(cell(g, 0, 0), alive_neighbours));
     
     //top right
-    alive_neighbours = g->grid[g->len-1][g->wid-2] + g->grid[g->len-1][g->wid-1] + g->grid[g->len-1][0] + g->grid[0][g->wid-2] + g->grid[0][0] + g->grid[1][g->wid-2] + g->grid[1][g->wid-1] + g->grid[1][0] ;
-    g->next_grid[0][g->wid-1] = alive_or_dead(g->grid[0][g->wid-1], alive_neighbours);
+    alive_neighbours = cell(g, g->len-1, g->wid-2) + cell(g, g->len-1, g->wid-1) + cell(g, g->len-1, 0) + cell(g, 0, g->wid-2) + cell(g, 0, 0) + cell(g, 1, g->wid-2) + cell(g, 1, g->wid-1) + cell(g, 1, 0) ;
+    set_cell(g->next_grid, g->stride, 0, g->wid-1, alive_or_dead(cell(g, 0, g->wid-1), alive_neighbours));
     
     //bottom left
-    alive_neighbours = g->grid[g->len-2][g->wid-1] + g->grid[g->len-2][0] + g->grid[g->len-2][1] + g->grid[g->len-1][g->wid-1] + g->grid[g->len-1][1] + g->grid[0][g->wid-1] + g->grid[0][0] + g->grid[0][1] ;
-    g->next_grid[g->len-1][0] = alive_or_dead(g->grid[g->len-1][0], alive_neighbours);
+    alive_neighbours = cell(g, g->len-2, g->wid-1) + cell(g, g->len-2, 0) + cell(g, g->len-2, 1) + cell(g, g->len-1, g->wid-1) + cell(g, g->len-1, 1) + cell(g, 0, g->wid-1) + cell(g, 0, 0) + cell(g, 0, 1) ;
+    set_cell(g->next_grid, g->stride, g->len-1, 0, alive_or_dead(cell(g, g->len-1, 0), alive_neighbours));
     
     //bottom right
-    alive_neighbours = g->grid[g->len-2][g->wid-2] + g->grid[g->len-2][g->wid-1] + g->grid[g->len-2][0] + g->grid[g->len-1][g->wid-2] + g->grid[g->len-1][0] + g->grid[0][g->wid-2] + g->grid[0][g->wid-1] + g->grid[0][0] ;
-    g->next_grid[g->len-1][g->wid-1] = alive_or_dead(g->grid[g->len-1][g->wid-1], alive_neighbours);
+    alive_neighbours = cell(g, g->len-2, g->wid-2) + cell(g, g->len-2, g->wid-1) + cell(g, g->len-2, 0) + cell(g, g->len-1, g->wid-2) + cell(g, g->len-1, 0) + cell(g, 0, g->wid-2) + cell(g, 0, g->wid-1) + cell(g, 0, 0) ;
+    set_cell(g->next_grid, g->stride, g->len-1, g->wid-1, alive_or_dead(cell(g, g->len-1, g->wid-1), alive_neighbours));
+    
+    //This kernel doesn't keep track of tiles, so every tile is counted as stepped, alive and changed.
+    g->active_count = g->tiles_down * g->tiles_across;
+    for(int t=0; t<g->active_count; t++){
+        g->active[t] = t;
+        g->next_live[t] = 1;
+        g->next_changed[t] = 1;
+    }
 }
 
 
-//This function lets the user create their own starting grid, each position at a time. This is a slow process but works decently for grids smaller than 10x10.
-void custom(Grid_info *g){
-    printf("\nPlease enter your values in for your custom board - 0 is dead, 1 is alive a:\n");
-    for (int l=0 ; l < g->len ; l++){
-        for (int w=0 ; w < g->wid ; w++){
-            printf("Please enter your input for the [%d][%d] position:\n",l,w);
-            g->grid[l][w] = input(0,1);
-        }
+//Works out the next state of 64 cells at once (or 64 cells in every lane of a vector, since the same code is used for the AVX kernels). Each input holds one neighbour of every cell in the word (up-left, up, up-right, left, right, down-left, down, down-right), and the eight are added with bitwise adders: each row of three is summed into a twos and ones bit, the ones are added together, and the twos must then add up to exactly one. Conway's rules need a total of 3, or 2 for a cell that is already alive.
+#define LIFE_LOGIC(T, result, ul, u, ur, l, r, dl, d, dr, self) do { \
+    /* Row above and row below (full adders), and the two side cells (half adder). */ \
+    T up_ones_ = (ul) ^ (u) ^ (ur), up_twos_ = ((ul) & (u)) | ((ur) & ((ul) ^ (u))); \
+    T down_ones_ = (dl) ^ (d) ^ (dr), down_twos_ = ((dl) & (d)) | ((dr) & ((dl) ^ (d))); \
+    T side_ones_ = (l) ^ (r), side_twos_ = (l) & (r); \
+    /* Adding the three ones bits gives the final ones bit and one more twos bit. */ \
+    T ones_ = up_ones_ ^ down_ones_ ^ side_ones_; \
+    T carry_ = (up_ones_ & down_ones_) | (side_ones_ & (up_ones_ ^ down_ones_)); \
+    /* Exactly one of the four twos bits must be set for a total of 2 or 3. */ \
+    T pair1_ = up_twos_ ^ down_twos_, pair2_ = side_twos_ ^ carry_; \
+    T one_two_ = (pair1_ ^ pair2_) & ~((up_twos_ & down_twos_) | (side_twos_ & carry_) | (pair1_ & pair2_)); \
+    (result) = one_two_ & (ones_ | (self)); \
+} while (0)
+
+//Adds up the eight neighbours of 64 cells at once in the same way as LIFE_LOGIC, but carries on to the full count of 0 to 8 as four bits (c0 is the lowest), for the rules that care about more than 2 or 3 neighbours. The four twos bits are added with two half adders and then a full adder.
+#define COUNT_LOGIC(T, c0, c1, c2, c3, ul, u, ur, l, r, dl, d, dr) do { \
+    T up_ones_ = (ul) ^ (u) ^ (ur), up_twos_ = ((ul) & (u)) | ((ur) & ((ul) ^ (u))); \
+    T down_ones_ = (dl) ^ (d) ^ (dr), down_twos_ = ((dl) & (d)) | ((dr) & ((dl) ^ (d))); \
+    T side_ones_ = (l) ^ (r), side_twos_ = (l) & (r); \
+    T carry_ = (up_ones_ & down_ones_) | (side_ones_ & (up_ones_ ^ down_ones_)); \
+    T pair1_ = up_twos_ ^ down_twos_, pair2_ = side_twos_ ^ carry_; \
+    T fours1_ = up_twos_ & down_twos_, fours2_ = side_twos_ & carry_, fours3_ = pair1_ & pair2_; \
+    (c0) = up_ones_ ^ down_ones_ ^ side_ones_; \
+    (c1) = pair1_ ^ pair2_; \
+    (c2) = fours1_ ^ fours2_ ^ fours3_; \
+    (c3) = (fours1_ & fours2_) | (fours3_ & (fours1_ ^ fours2_)); \
+} while (0)
+
+//HighLife (B36/S23): a dead cell is born with 3 or 6 neighbours (0011 or 0110) and a live one survives with 2 or 3 (001x). A count with c1 set can't have c3 set, so c3 never needs looking at.
+#define HIGHLIFE_LOGIC(T, result, ul, u, ur, l, r, dl, d, dr, self) do { \
+    T c0_, c1_, c2_, c3_; \
+    COUNT_LOGIC(T, c0_, c1_, c2_, c3_, ul, u, ur, l, r, dl, d, dr); \
+    (void)c3_; \
+    (result) = c1_ & ((~(self) & (c0_ ^ c2_)) | ((self) & ~c2_)); \
+} while (0)
+
+//Day & Night (B3678/S34678): a cell is born with 3, 6, 7 or 8 neighbours, and a live cell also survives with 4 (0100).
+#define DAY_NIGHT_LOGIC(T, result, ul, u, ur, l, r, dl, d, dr, self) do { \
+    T c0_, c1_, c2_, c3_; \
+    COUNT_LOGIC(T, c0_, c1_, c2_, c3_, ul, u, ur, l, r, dl, d, dr); \
+    (result) = c3_ | (c1_ & (c0_ | c2_)) | ((self) & c2_ & ~(c1_ | c0_)); \
+} while (0)
+
+//Seeds (B2/S): a dead cell is born with exactly 2 neighbours (0010) and every live cell dies.
+#define SEEDS_LOGIC(T, result, ul, u, ur, l, r, dl, d, dr, self) do { \
+    T c0_, c1_, c2_, c3_; \
+    COUNT_LOGIC(T, c0_, c1_, c2_, c3_, ul, u, ur, l, r, dl, d, dr); \
+    (void)c3_; \
+    (result) = ~(self) & c1_ & ~(c0_ | c2_); \
+} while (0)
+
+//Any other rule: each count from 0 to 8 is matched against the four count bits, and the cells with that count take their next state from the born and survive bits of life_rule. The rule is the same for every word, so the branches on it are always guessed right.
+#define GENERIC_LOGIC(T, result, ul, u, ur, l, r, dl, d, dr, self) do { \
+    T c0_, c1_, c2_, c3_, zero_ = {0}; \
+    COUNT_LOGIC(T, c0_, c1_, c2_, c3_, ul, u, ur, l, r, dl, d, dr); \
+    (result) = zero_; \
+    for(int n_=0; n_<9; n_++){ \
+        if (((life_rule.born | life_rule.survive) >> n_) & 1) { \
+            T match_ = ((n_ & 1) ? c0_ : ~c0_) & ((n_ & 2) ? c1_ : ~c1_) & ((n_ & 4) ? c2_ : ~c2_) & ((n_ & 8) ? c3_ : ~c3_); \
+            T born_ = zero_ | ((uint64_t)0 - ((life_rule.born >> n_) & 1)), survive_ = zero_ | ((uint64_t)0 - ((life_rule.survive >> n_) & 1)); \
+            (result) |= match_ & ((~(self) & born_) | ((self) & survive_)); \
+        } \
+    } \
+} while (0)
+
+//Works out word k of a row on its own. The left and right neighbours of each cell are made by shifting the words by one bit and carrying in the end bit of the word beside them. In the first and last word of a row that carry comes from the other end of the row, which is how the board loops round at the sides. last is the bit position of the final column within its word. One copy is made for each rule's logic.
+#define STEP_WORD(name, LOGIC) \
+static inline uint64_t name(const uint64_t *up, const uint64_t *mid, const uint64_t *down, size_t k, size_t words, int last){ \
+    size_t before = (k == 0) ? words - 1 : k - 1; \
+    size_t after = (k + 1 == words) ? 0 : k + 1; \
+    int from_before = (k == 0) ? last : WORD_BITS - 1; \
+    int to_after = (k + 1 == words) ? last : WORD_BITS - 1; \
+    uint64_t result; \
+    \
+    uint64_t ul = (up[k] << 1) | ((up[before] >> from_before) & 1); \
+    uint64_t l = (mid[k] << 1) | ((mid[before] >> from_before) & 1); \
+    uint64_t dl = (down[k] << 1) | ((down[before] >> from_before) & 1); \
+    uint64_t ur = (up[k] >> 1) | ((up[after] & 1) << to_after); \
+    uint64_t r = (mid[k] >> 1) | ((mid[after] & 1) << to_after); \
+    uint64_t dr = (down[k] >> 1) | ((down[after] & 1) << to_after); \
+    LOGIC(uint64_t, result, ul, up[k], ur, l, r, dl, down[k], dr, mid[k]); \
+    return result; \
+}
+
+STEP_WORD(step_word, LIFE_LOGIC)
+STEP_WORD(step_word_highlife, HIGHLIFE_LOGIC)
+STEP_WORD(step_word_day_night, DAY_NIGHT_LOGIC)
+STEP_WORD(step_word_seeds, SEEDS_LOGIC)
+STEP_WORD(step_word_generic, GENERIC_LOGIC)
+
+//Steps words first to end-1 of one row of the board with the logic of one rule, using the matching copy of step_word(). up, mid and down are the rows above, on and below the row being worked out (already wrapped round at the top and bottom of the board). Only the first and last words of a row need the wrap round, so the words in between take a simpler path where the carries always come from the next word along. The same code makes the plain 64 bit kernel (T is uint64_t) and the AVX2 and AVX-512 kernels, which do the middle of the row 4 or 8 words at a time in 256 or 512 bit registers, loading the words either side one word out of line to get the carries. Words left over when the row doesn't divide into whole vectors go through step_word(). Along the way it ORs together the words written, and the words written XORed with the words they replace, to find out whether anything is alive and whether anything changed.
+#define ROW_KERNEL(name, T, attributes, LOGIC, step_word) \
+attributes Row_result name(const uint64_t *up, const uint64_t *mid, const uint64_t *down, uint64_t *out, size_t first, size_t end, int wid){ \
+    const size_t lanes = sizeof(T) / sizeof(uint64_t); \
+    size_t words = ((size_t)wid + WORD_BITS - 1) / WORD_BITS, k = first; \
+    size_t stop = (end < words) ? end : words - 1; \
+    int last = (wid - 1) % WORD_BITS; \
+    uint64_t lane[sizeof(T) / sizeof(uint64_t)]; \
+    Row_result found = {0, 0}; \
+    T alive_lanes = {0}, changed_lanes = {0}; \
+    if (k == 0) { \
+        out[0] = step_word(up, mid, down, 0, words, last); \
+        k = 1; \
+    } \
+    for(; k+lanes<=stop; k+=lanes){ \
+        T u = *(const T *)(up+k), up_before = *(const T *)(up+k-1), up_after = *(const T *)(up+k+1); \
+        T m = *(const T *)(mid+k), mid_before = *(const T *)(mid+k-1), mid_after = *(const T *)(mid+k+1); \
+        T d = *(const T *)(down+k), down_before = *(const T *)(down+k-1), down_after = *(const T *)(down+k+1); \
+        T ul = (u << 1) | (up_before >> 63), ur = (u >> 1) | (up_after << 63); \
+        T l = (m << 1) | (mid_before >> 63), r = (m >> 1) | (mid_after << 63); \
+        T dl = (d << 1) | (down_before >> 63), dr = (d >> 1) | (down_after << 63), result; \
+        LOGIC(T, result, ul, u, ur, l, r, dl, d, dr, m); \
+        *(T *)(out+k) = result; \
+        alive_lanes |= result; \
+        changed_lanes |= result ^ m; \
+    } \
+    for(; k<stop; k++){ \
+        out[k] = step_word(up, mid, down, k, words, last); \
+        found.alive |= out[k]; \
+        found.changed |= out[k] ^ mid[k]; \
+    } \
+    if (end == words) { \
+        if (words > 1) { \
+            out[words-1] = step_word(up, mid, down, words-1, words, last); \
+        } \
+        /* Bits shifted past the end of the row are cleared so the padding stays dead. */ \
+        out[words-1] &= (last == WORD_BITS - 1) ? ~(uint64_t)0 : ((uint64_t)1 << (last + 1)) - 1; \
+        found.alive |= out[words-1]; \
+        found.changed |= out[words-1] ^ mid[words-1]; \
+    } \
+    if (first == 0 && end > 0) { \
+        found.alive |= out[0]; \
+        found.changed |= out[0] ^ mid[0]; \
+    } \
+    memcpy(lane, &alive_lanes, sizeof(T)); \
+    for(size_t i=0; i<lanes; i++){ \
+        found.alive |= lane[i]; \
+    } \
+    memcpy(lane, &changed_lanes, sizeof(T)); \
+    for(size_t i=0; i<lanes; i++){ \
+        found.changed |= lane[i]; \
+    } \
+    return found; \
+}
+
+ROW_KERNEL(step_row_swar, uint64_t, , LIFE_LOGIC, step_word)
+ROW_KERNEL(step_row_swar_highlife, uint64_t, , HIGHLIFE_LOGIC, step_word_highlife)
+ROW_KERNEL(step_row_swar_day_night, uint64_t, , DAY_NIGHT_LOGIC, step_word_day_night)
+ROW_KERNEL(step_row_swar_seeds, uint64_t, , SEEDS_LOGIC, step_word_seeds)
+ROW_KERNEL(step_row_swar_generic, uint64_t, , GENERIC_LOGIC, step_word_generic)
+
+//Each vector kernel is compiled for its own instruction set, so one binary carries all of them and the widest one the processor supports is picked when the program starts.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HAVE_X86_KERNELS 1
+typedef uint64_t vec4 __attribute__((vector_size(32), aligned(8)));
+typedef uint64_t vec8 __attribute__((vector_size(64), aligned(8)));
+
+ROW_KERNEL(step_row_avx2, vec4, __attribute__((target("avx2"))), LIFE_LOGIC, step_word)
+ROW_KERNEL(step_row_avx2_highlife, vec4, __attribute__((target("avx2"))), HIGHLIFE_LOGIC, step_word_highlife)
+ROW_KERNEL(step_row_avx2_day_night, vec4, __attribute__((target("avx2"))), DAY_NIGHT_LOGIC, step_word_day_night)
+ROW_KERNEL(step_row_avx2_seeds, vec4, __attribute__((target("avx2"))), SEEDS_LOGIC, step_word_seeds)
+ROW_KERNEL(step_row_avx2_generic, vec4, __attribute__((target("avx2"))), GENERIC_LOGIC, step_word_generic)
+ROW_KERNEL(step_row_avx512, vec8, __attribute__((target("avx512f"))), LIFE_LOGIC, step_word)
+ROW_KERNEL(step_row_avx512_highlife, vec8, __attribute__((target("avx512f"))), HIGHLIFE_LOGIC, step_word_highlife)
+ROW_KERNEL(step_row_avx512_day_night, vec8, __attribute__((target("avx512f"))), DAY_NIGHT_LOGIC, step_word_day_night)
+ROW_KERNEL(step_row_avx512_seeds, vec8, __attribute__((target("avx512f"))), SEEDS_LOGIC, step_word_seeds)
+ROW_KERNEL(step_row_avx512_generic, vec8, __attribute__((target("avx512f"))), GENERIC_LOGIC, step_word_generic)
+#endif
+
+//The row counters (see count_row), built the same way as the row kernels: a plain one, and one compiled for the popcount instruction.
+#define ROW_COUNTER(name, attributes) \
+static attributes void name(const uint64_t *before, const uint64_t *after, size_t first, size_t end, uint64_t counts[3], uint64_t *columns){ \
+    for(size_t k=first; k<end; k++){ \
+        counts[0] += (uint64_t)__builtin_popcountll(after[k]); \
+        counts[1] += (uint64_t)__builtin_popcountll(after[k] & ~before[k]); \
+        counts[2] += (uint64_t)__builtin_popcountll(before[k] & ~after[k]); \
+        columns[k - first] |= after[k]; \
+    } \
+}
+
+ROW_COUNTER(count_row_plain, )
+#ifdef HAVE_X86_KERNELS
+ROW_COUNTER(count_row_popcnt, __attribute__((target("popcnt"))))
+#endif
+
+//The row kernels for each kind of rule (see RULE_CONWAY), on each instruction set: plain 64 bit, AVX2 and AVX-512. The vector ones are left empty if this binary doesn't have them.
+Row_kernel rule_kernels[RULE_KINDS][3] = {
+#ifdef HAVE_X86_KERNELS
+    {step_row_swar, step_row_avx2, step_row_avx512},
+    {step_row_swar_highlife, step_row_avx2_highlife, step_row_avx512_highlife},
+    {step_row_swar_day_night, step_row_avx2_day_night, step_row_avx512_day_night},
+    {step_row_swar_seeds, step_row_avx2_seeds, step_row_avx512_seeds},
+    {step_row_swar_generic, step_row_avx2_generic, step_row_avx512_generic},
+#else
+    {step_row_swar, NULL, NULL},
+    {step_row_swar_highlife, NULL, NULL},
+    {step_row_swar_day_night, NULL, NULL},
+    {step_row_swar_seeds, NULL, NULL},
+    {step_row_swar_generic, NULL, NULL},
+#endif
+};
+
+//Steps one row of 64 boards in lockstep with the logic of one rule. Bit b of every word belongs to board b, so the neighbours of a cell are simply the words beside it, above and below, and the logic needs no shifts at all. As with the row kernels, the plain 64 bit kernel does one cell of the row at a time and the AVX2 and AVX-512 ones do 4 or 8 cells at a time, with the cells left over done one at a time.
+#define LOCKSTEP_KERNEL(name, T, attributes, LOGIC) \
+attributes void name(const uint64_t *up, const uint64_t *mid, const uint64_t *down, const uint64_t *before, uint64_t *out, int wid, uint64_t running, uint64_t found[2]){ \
+    const size_t lanes = sizeof(T) / sizeof(uint64_t); \
+    uint64_t lane[sizeof(T) / sizeof(uint64_t)], changed = 0, repeated = 0; \
+    T changed_lanes = {0}, repeated_lanes = {0}, keep = {0}; \
+    size_t k = 1; \
+    keep |= running; \
+    for(; k+lanes<=(size_t)wid+1; k+=lanes){ \
+        T ul = *(const T *)(up+k-1), u = *(const T *)(up+k), ur = *(const T *)(up+k+1); \
+        T l = *(const T *)(mid+k-1), m = *(const T *)(mid+k), r = *(const T *)(mid+k+1); \
+        T dl = *(const T *)(down+k-1), d = *(const T *)(down+k), dr = *(const T *)(down+k+1), result; \
+        LOGIC(T, result, ul, u, ur, l, r, dl, d, dr, m); \
+        result = (result & keep) | (m & ~keep); \
+        *(T *)(out+k) = result; \
+        changed_lanes |= result ^ m; \
+        repeated_lanes |= result ^ *(const T *)(before+k); \
+    } \
+    for(; k<=(size_t)wid; k++){ \
+        uint64_t result; \
+        LOGIC(uint64_t, result, up[k-1], up[k], up[k+1], mid[k-1], mid[k+1], down[k-1], down[k], down[k+1], mid[k]); \
+        out[k] = (result & running) | (mid[k] & ~running); \
+        changed |= out[k] ^ mid[k]; \
+        repeated |= out[k] ^ before[k]; \
+    } \
+    memcpy(lane, &changed_lanes, sizeof(T)); \
+    for(size_t i=0; i<lanes; i++){ \
+        changed |= lane[i]; \
+    } \
+    memcpy(lane, &repeated_lanes, sizeof(T)); \
+    for(size_t i=0; i<lanes; i++){ \
+        repeated |= lane[i]; \
+    } \
+    found[0] |= changed; \
+    found[1] |= repeated; \
+}
+
+LOCKSTEP_KERNEL(lockstep_swar, uint64_t, , LIFE_LOGIC)
+LOCKSTEP_KERNEL(lockstep_swar_highlife, uint64_t, , HIGHLIFE_LOGIC)
+LOCKSTEP_KERNEL(lockstep_swar_day_night, uint64_t, , DAY_NIGHT_LOGIC)
+LOCKSTEP_KERNEL(lockstep_swar_seeds, uint64_t, , SEEDS_LOGIC)
+LOCKSTEP_KERNEL(lockstep_swar_generic, uint64_t, , GENERIC_LOGIC)
+#ifdef HAVE_X86_KERNELS
+LOCKSTEP_KERNEL(lockstep_avx2, vec4, __attribute__((target("avx2"))), LIFE_LOGIC)
+LOCKSTEP_KERNEL(lockstep_avx2_highlife, vec4, __attribute__((target("avx2"))), HIGHLIFE_LOGIC)
+LOCKSTEP_KERNEL(lockstep_avx2_day_night, vec4, __attribute__((target("avx2"))), DAY_NIGHT_LOGIC)
+LOCKSTEP_KERNEL(lockstep_avx2_seeds, vec4, __attribute__((target("avx2"))), SEEDS_LOGIC)
+LOCKSTEP_KERNEL(lockstep_avx2_generic, vec4, __attribute__((target("avx2"))), GENERIC_LOGIC)
+LOCKSTEP_KERNEL(lockstep_avx512, vec8, __attribute__((target("avx512f"))), LIFE_LOGIC)
+LOCKSTEP_KERNEL(lockstep_avx512_highlife, vec8, __attribute__((target("avx512f"))), HIGHLIFE_LOGIC)
+LOCKSTEP_KERNEL(lockstep_avx512_day_night, vec8, __attribute__((target("avx512f"))), DAY_NIGHT_LOGIC)
+LOCKSTEP_KERNEL(lockstep_avx512_seeds, vec8, __attribute__((target("avx512f"))), SEEDS_LOGIC)
+LOCKSTEP_KERNEL(lockstep_avx512_generic, vec8, __attribute__((target("avx512f"))), GENERIC_LOGIC)
+#endif
+
+//The lockstep kernels, laid out in the same way as rule_kernels.
+Lockstep_kernel lockstep_kernels[RULE_KINDS][3] = {
+#ifdef HAVE_X86_KERNELS
+    {lockstep_swar, lockstep_avx2, lockstep_avx512},
+    {lockstep_swar_highlife, lockstep_avx2_highlife, lockstep_avx512_highlife},
+    {lockstep_swar_day_night, lockstep_avx2_day_night, lockstep_avx512_day_night},
+    {lockstep_swar_seeds, lockstep_avx2_seeds, lockstep_avx512_seeds},
+    {lockstep_swar_generic, lockstep_avx2_generic, lockstep_avx512_generic},
+#else
+    {lockstep_swar, NULL, NULL},
+    {lockstep_swar_highlife, NULL, NULL},
+    {lockstep_swar_day_night, NULL, NULL},
+    {lockstep_swar_seeds, NULL, NULL},
+    {lockstep_swar_generic, NULL, NULL},
+#endif
+};
+
+//Works out the next state of one word of cells with the logic of the rule being run, for the code that steps boards a word at a time outside the row kernels. The switch is on a value that never changes during a run, so its branch is always guessed right.
+static inline uint64_t rule_word(uint64_t ul, uint64_t u, uint64_t ur, uint64_t l, uint64_t r, uint64_t dl, uint64_t d, uint64_t dr, uint64_t self){
+    uint64_t result;
+    switch (life_rule.kind) {
+        case RULE_CONWAY: LIFE_LOGIC(uint64_t, result, ul, u, ur, l, r, dl, d, dr, self); break;
+        case RULE_HIGHLIFE: HIGHLIFE_LOGIC(uint64_t, result, ul, u, ur, l, r, dl, d, dr, self); break;
+        case RULE_DAY_NIGHT: DAY_NIGHT_LOGIC(uint64_t, result, ul, u, ur, l, r, dl, d, dr, self); break;
+        case RULE_SEEDS: SEEDS_LOGIC(uint64_t, result, ul, u, ur, l, r, dl, d, dr, self); break;
+        default: GENERIC_LOGIC(uint64_t, result, ul, u, ur, l, r, dl, d, dr, self); break;
     }
+    return result;
 }
 
-//This function weaves all the other functions together and takes the correct steps for each iteration of the game. The game will stop if there is no change between iterations.
-void run(int iterations, Grid_info *g){
-    int j=0, stop=0, same;
-    while (j<iterations && stop == 0){
-        next(g);
-        print_board(g);
-        sleep(1);
-        printf("\n\n\n\n\n\n\n\n\n\n\n\n");
-        
-        //For loop and if statement to check if boards are identitcal between iterations.
-        same = 0;
-        for(int l=0; l<g->len; l++){
-            for(int w=0; w<g->wid; w++){
-                if (g->grid[l][w] == g->next_grid[l][w]){
-                    same += 1;
-                }
+//Picks the widest row kernel and lockstep kernel that this processor can run for the rule being run, and the row counter, using the CPUID feature flags. It is called when the program starts and whenever the rule changes, and the choice can be overridden with the GOL_KERNEL environment variable (swar, avx2 or avx512) for testing.
+void select_kernel(void){
+    const char *forced = getenv("GOL_KERNEL");
+    step_row = rule_kernels[life_rule.kind][0];
+    step_lockstep = lockstep_kernels[life_rule.kind][0];
+    kernel_name = "swar";
+    count_row = count_row_plain;
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("popcnt")) {
+        count_row = count_row_popcnt;
+    }
+    if (__builtin_cpu_supports("avx512f") && (forced == NULL || strcmp(forced, "avx512") == 0)) {
+        step_row = rule_kernels[life_rule.kind][2];
+        step_lockstep = lockstep_kernels[life_rule.kind][2];
+        kernel_name = "avx512";
+    }
+    else if (__builtin_cpu_supports("avx2") && (forced == NULL || strcmp(forced, "avx2") == 0 || strcmp(forced, "avx512") == 0)) {
+        step_row = rule_kernels[life_rule.kind][1];
+        step_lockstep = lockstep_kernels[life_rule.kind][1];
+        kernel_name = "avx2";
+    }
+#else
+    (void)forced;
+#endif
+}
+
+//Reads a rule in B/S notation ("B36/S23", in either order and either case) or in the older survival/birth notation used by some RLE files ("23/36"). Rules where a cell is born with no neighbours (B0) are turned down, since the empty space around a pattern would then fill up, which the tile skipping, the sparse plane and HashLife all rely on never happening. It returns -1 if text isn't a rule this program can run.
+int parse_rule(Rule *rule, const char *text){
+    const char *slash = strchr(text, '/');
+    uint16_t sets[2] = {0, 0};
+    char letters[2] = {0, 0};
+    
+    memset(rule, 0, sizeof(Rule));
+    if (slash == NULL || strchr(slash + 1, '/') != NULL) {
+        return -1;
+    }
+    for(int p=0; p<2; p++){
+        const char *c = (p == 0) ? text : slash + 1, *end = (p == 0) ? slash : slash + strlen(slash);
+        if (c < end && (*c == 'B' || *c == 'b' || *c == 'S' || *c == 's')) {
+            letters[p] = (*c == 'B' || *c == 'b') ? 'B' : 'S';
+            c++;
+        }
+        for(; c<end; c++){
+            if (*c < '0' || *c > '8') {
+                return -1;
             }
+            sets[p] |= (uint16_t)(1 << (*c - '0'));
         }
-        if (same == (g->len * g->wid)){
-            printf("No change in grid so game will stop.\n");
-            stop = 1;
+    }
+    //Without letters, the numbers before the slash are for survival and the ones after it for birth.
+    if ((letters[0] == 'B' && letters[1] == 'S') == 0) {
+        if ((letters[0] == 0 && letters[1] == 0) == 0 && (letters[0] == 'S' && letters[1] == 'B') == 0) {
+            return -1;
         }
-        
-        // Readying grid for next interation
-        for(int l=0; l<g->len; l++){
-            for(int w=0; w<g->wid; w++){
-                g->grid[l][w] = g->next_grid[l][w];
-            }
+        uint16_t swap = sets[0];
+        sets[0] = sets[1];
+        sets[1] = swap;
+    }
+    if (sets[0] & 1) {
+        return -1;
+    }
+    rule->born = sets[0];
+    rule->survive = sets[1];
+    int n = snprintf(rule->name, sizeof(rule->name), "B");
+    for(int i=0; i<9; i++){
+        n += (rule->born >> i & 1) ? snprintf(rule->name + n, sizeof(rule->name) - n, "%d", i) : 0;
+    }
+    n += snprintf(rule->name + n, sizeof(rule->name) - n, "/S");
+    for(int i=0; i<9; i++){
+        n += (rule->survive >> i & 1) ? snprintf(rule->name + n, sizeof(rule->name) - n, "%d", i) : 0;
+    }
+    for(int i=0; i<9; i++){
+        rule->table[0][i] = (rule->born >> i) & 1;
+        rule->table[1][i] = (rule->survive >> i) & 1;
+    }
+    rule->kind = (strcmp(rule->name, "B3/S23") == 0) ? RULE_CONWAY : (strcmp(rule->name, "B36/S23") == 0) ? RULE_HIGHLIFE : (strcmp(rule->name, "B3678/S34678") == 0) ? RULE_DAY_NIGHT : (strcmp(rule->name, "B2/S") == 0) ? RULE_SEEDS : RULE_GENERIC;
+    return 0;
+}
+
+//Makes text the rule every board is stepped with, and picks the row kernels for it. It returns -1, leaving the rule as it was, if text isn't a rule this program can run.
+int set_rule(const char *text){
+    Rule rule;
+    if (parse_rule(&rule, text) != 0) {
+        printf("%s is not a rule this program can run\n", text);
+        return -1;
+    }
+    life_rule = rule;
+    select_kernel();
+    return 0;
+}
+
+//Sets up a barrier for count threads.
+void barrier_init(Barrier *b, int count){
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->opened, NULL);
+    b->count = count;
+    b->waiting = 0;
+    b->phase = 0;
+}
+
+//Waits until all the threads using the barrier have called this function. The last thread to arrive opens the barrier for everyone.
+void barrier_wait(Barrier *b){
+    pthread_mutex_lock(&b->lock);
+    unsigned long phase = b->phase;
+    b->waiting += 1;
+    if (b->waiting == b->count) {
+        b->waiting = 0;
+        b->phase += 1;
+        pthread_cond_broadcast(&b->opened);
+    }
+    else{
+        while (phase == b->phase) {
+            pthread_cond_wait(&b->opened, &b->lock);
         }
-        j += 1;
     }
+    pthread_mutex_unlock(&b->lock);
 }
 
-// This function lets the user choose 1 of 5 preconfigured grids to be but into the structure and therefore be run in the game. The grids are displayed to the user so they can choose.
-void preset(Grid_info *g){
-    int grid1[10][10], grid2[10][10] = {{0,0,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,1,0,0}, {0,0,0,0,0,1,0,1,0,0}, {0,0,0,0,0,0,1,1,0,0}, {0,0,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0,0,0}}, grid3[40][40], grid4[40][40], grid5[40][40];
-    
-    //Grid 1 has cells that are randomised alive or dead (0 or 1).
-    for(int l=0; l<10; l++){
-        for(int w=0; w<10; w++){
-            grid1[l][w] = rand() % 2;
+void barrier_destroy(Barrier *b){
+    pthread_mutex_destroy(&b->lock);
+    pthread_cond_destroy(&b->opened);
+}
+
+//The loop each worker thread runs for the life of the pool: wait for a job, do this thread's share of it, then report back at the finish barrier.
+static void *pool_worker(void *arg){
+    Worker *worker = (Worker *)arg;
+    Thread_pool *pool = worker->pool;
+    while (1) {
+        barrier_wait(&pool->start);
+        if (pool->quit) {
+            break;
         }
+        pool->job(pool->arg, worker->id, pool->threads);
+        barrier_wait(&pool->finish);
     }
-    
-    //For the 3 larger grids, the contents of the arrays are appended from plain text files.
-    FILE *grid3_file;
-    grid3_file = fopen("/Users/jamiehoskyns/Documents/Coding/Project - Conway's Game of Life/Project - Conway's Game of Life/grid3.txt","r");
-    for(int l=0; l<40; l++){
-        fscanf(grid3_file, "%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i", &grid3[l][0],&grid3[l][1],&grid3[l][2],&grid3[l][3],&grid3[l][4],&grid3[l][5],&grid3[l][6],&grid3[l][7],&grid3[l][8],&grid3[l][9],&grid3[l][10],&grid3[l][11],&grid3[l][12],&grid3[l][13],&grid3[l][14],&grid3[l][15],&grid3[l][16],&grid3[l][17],&grid3[l][18],&grid3[l][19],&grid3[l][20],&grid3[l][21],&grid3[l][22],&grid3[l][23],&grid3[l][24],&grid3[l][25],&grid3[l][26],&grid3[l][27],&grid3[l][28],&grid3[l][29],&grid3[l][30],&grid3[l][31],&grid3[l][32],&grid3[l][33],&grid3[l][34],&grid3[l][35],&grid3[l][36],&grid3[l][37],&grid3[l][38],&grid3[l][39]);
+    return NULL;
+}
+
+//Starts a pool of worker threads. It returns NULL if the threads could not be started.
+Thread_pool *pool_create(int threads){
+    Thread_pool *pool = (Thread_pool *)malloc(sizeof(Thread_pool));
+    if (pool == NULL) {
+        return NULL;
     }
-    fclose(grid3_file);
-    
-    FILE *grid4_file;
-    grid4_file = fopen("/Users/jamiehoskyns/Documents/Coding/Project - Conway's Game of Life/Project - Conway's Game of Life/grid4.txt","r");
-    for(int l=0; l<40; l++){
-        fscanf(grid4_file, "%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i", &grid4[l][0],&grid4[l][1],&grid4[l][2],&grid4[l][3],&grid4[l][4],&grid4[l][5],&grid4[l][6],&grid4[l][7],&grid4[l][8],&grid4[l][9],&grid4[l][10],&grid4[l][11],&grid4[l][12],&grid4[l][13],&grid4[l][14],&grid4[l][15],&grid4[l][16],&grid4[l][17],&grid4[l][18],&grid4[l][19],&grid4[l][20],&grid4[l][21],&grid4[l][22],&grid4[l][23],&grid4[l][24],&grid4[l][25],&grid4[l][26],&grid4[l][27],&grid4[l][28],&grid4[l][29],&grid4[l][30],&grid4[l][31],&grid4[l][32],&grid4[l][33],&grid4[l][34],&grid4[l][35],&grid4[l][36],&grid4[l][37],&grid4[l][38],&grid4[l][39]);
+    pool->threads = (threads < 1) ? 1 : threads;
+    pool->workers = (Worker *)malloc((size_t)pool->threads * sizeof(Worker));
+    pool->quit = 0;
+    if (pool->workers == NULL) {
+        free(pool);
+        return NULL;
     }
-    fclose(grid4_file);
-    
-    FILE *grid5_file;
-    grid5_file = fopen("/Users/jamiehoskyns/Documents/Coding/Project - Conway's Game of Life/Project - Conway's Game of Life/grid5.txt","r");
-    for(int l=0; l<40; l++){
-        fscanf(grid5_file, "%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i%i", &grid5[l][0],&grid5[l][1],&grid5[l][2],&grid5[l][3],&grid5[l][4],&grid5[l][5],&grid5[l][6],&grid5[l][7],&grid5[l][8],&grid5[l][9],&grid5[l][10],&grid5[l][11],&grid5[l][12],&grid5[l][13],&grid5[l][14],&grid5[l][15],&grid5[l][16],&grid5[l][17],&grid5[l][18],&grid5[l][19],&grid5[l][20],&grid5[l][21],&grid5[l][22],&grid5[l][23],&grid5[l][24],&grid5[l][25],&grid5[l][26],&grid5[l][27],&grid5[l][28],&grid5[l][29],&grid5[l][30],&grid5[l][31],&grid5[l][32],&grid5[l][33],&grid5[l][34],&grid5[l][35],&grid5[l][36],&grid5[l][37],&grid5[l][38],&grid5[l][39]);
+    pool->deques = (Deque *)aligned_alloc(64, (size_t)pool->threads * sizeof(Deque));
+    if (pool->deques == NULL) {
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+    barrier_init(&pool->start, pool->threads);
+    barrier_init(&pool->finish, pool->threads);
+    for(int i=1; i<pool->threads; i++){
+        pool->workers[i].pool = pool;
+        pool->workers[i].id = i;
+        if (pthread_create(&pool->workers[i].thread, NULL, pool_worker, &pool->workers[i]) != 0) {
+            pool->threads = i;
+            break;
+        }
     }
-    fclose(grid5_file);
+    //If fewer threads could be started than were asked for, the barriers are set up again for the threads that are actually running (none of them can have got past the start barrier yet).
+    pthread_mutex_lock(&pool->start.lock);
+    pool->start.count = pool->threads;
+    pthread_mutex_unlock(&pool->start.lock);
+    pool->finish.count = pool->threads;
+    return pool;
+}
 
-    //Shows the grids to the user so they can choose one.
-    printf("Please choose one of the five following starting grids to run.\n");
-    printf("\nGrid 1 - Picked randomly (10x10):\n");
-    g->len = 10;
-    g->wid = 10;
-    equal_grids(g, grid1);
-    print_board(g);
-    sleep(2);
+//Runs job on every thread in the pool and returns once they have all finished. Each call of job is told its thread number and the number of threads so it can pick out its own share of the work.
+void pool_run(Thread_pool *pool, void (*job)(void *arg, int id, int threads), void *arg){
+    if (pool == NULL || pool->threads == 1) {
+        job(arg, 0, 1);
+        return;
+    }
+    pool->job = job;
+    pool->arg = arg;
+    barrier_wait(&pool->start);
+    job(arg, 0, pool->threads);
+    barrier_wait(&pool->finish);
+}
+
+//Stops the worker threads and frees the pool.
+void pool_destroy(Thread_pool *pool){
+    if (pool == NULL) {
+        return;
+    }
+    pool->quit = 1;
+    barrier_wait(&pool->start);
+    for(int i=1; i<pool->threads; i++){
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+    barrier_destroy(&pool->start);
+    barrier_destroy(&pool->finish);
+    free(pool->deques);
+    free(pool->workers);
+    free(pool);
+}
+
+//The number of threads to step the board with. It defaults to one per processor and can be set with the GOL_THREADS environment variable.
+int thread_count(void){
+    const char *threads = getenv("GOL_THREADS");
+    if (threads != NULL && atoi(threads) > 0) {
+        return atoi(threads);
+    }
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return (processors > 0) ? (int)processors : 1;
+}
+
+//Takes a tile from the bottom of the thread's own queue. It returns -1 once the queue is empty.
+int deque_take(Deque *d){
+    long bottom = atomic_load(&d->bottom) - 1;
+    atomic_store(&d->bottom, bottom);
+    long top = atomic_load(&d->top);
+    int tile = -1;
     
-    printf("Grid 2 - Glider (10x10):\n");
-    equal_grids(g, grid2);
-    print_board(g);
-    sleep(2);
+    if (top <= bottom) {
+        tile = d->items[bottom];
+        //If this is the last tile a thief may be taking it at the same moment, and whoever moves top first gets it.
+        if (top == bottom) {
+            if (!atomic_compare_exchange_strong(&d->top, &top, top + 1)) {
+                tile = -1;
+            }
+            atomic_store(&d->bottom, bottom + 1);
+        }
+    }
+    else{
+        atomic_store(&d->bottom, bottom + 1);
+    }
+    return tile;
+}
+
+//Steals a tile from the top of another thread's queue. It returns -1 if the queue is empty, or -2 if another thread got to the tile first (so it is worth trying again).
+int deque_steal(Deque *d){
+    long top = atomic_load(&d->top);
+    long bottom = atomic_load(&d->bottom);
     
-    printf("Grid 3 - Pattern (40x40):\n");
-    g->len = 40;
-    g->wid = 40;
-    equal_grids(g, grid3);
-    print_board(g);
-    sleep(2);
+    if (top >= bottom) {
+        return -1;
+    }
+    int tile = d->items[top];
+    if (!atomic_compare_exchange_strong(&d->top, &top, top + 1)) {
+        return -2;
+    }
+    return tile;
+}
+
+//Steps one tile of the board, row by row, and records in next_live and next_changed whether anything in the tile is alive afterwards and whether anything in it changed. Wrapping round at the top and bottom is done by choosing which rows are passed in as the rows above and below.
+//If statistics are being counted, each row that has anything alive in it or changed is counted while it is still in the cache from being stepped, and thread id's births and deaths, and the tile's population and box, are brought up to date. Rows that are empty before and after are skipped.
+void step_tile(Grid_info *g, int tile, int id){
+    int first_row = (tile / g->tiles_across) * TILE_ROWS;
+    int end_row = (first_row + TILE_ROWS < g->len) ? first_row + TILE_ROWS : g->len;
+    size_t words = ((size_t)g->wid + WORD_BITS - 1) / WORD_BITS;
+    size_t first = (size_t)(tile % g->tiles_across) * TILE_WORDS;
+    size_t end = (first + TILE_WORDS < words) ? first + TILE_WORDS : words;
+    uint64_t alive = 0, changed = 0, counts[3] = {0, 0, 0}, columns[TILE_WORDS] = {0};
+    int box[4] = {-1, -1, -1, -1};
+    Board_stats *s = g->stats;
     
-    printf("Grid 4 - Oscillator (40x40):\n");
-    equal_grids(g, grid4);
-    print_board(g);
-    sleep(2);
+    for(int l=first_row; l<end_row; l++){
+        const uint64_t *up = g->grid + (size_t)((l == 0) ? g->len - 1 : l - 1) * g->stride;
+        const uint64_t *down = g->grid + (size_t)((l + 1 == g->len) ? 0 : l + 1) * g->stride;
+        const uint64_t *before = g->grid + (size_t)l * g->stride;
+        uint64_t *after = g->next_grid + (size_t)l * g->stride;
+        Row_result found = step_row(up, before, down, after, first, end, g->wid);
+        alive |= found.alive;
+        changed |= found.changed;
+        if (s != NULL && (found.alive | found.changed) != 0) {
+            count_row(before, after, first, end, counts, columns);
+            if (found.alive != 0) {
+                box[0] = (box[0] < 0) ? l : box[0];
+                box[2] = l;
+            }
+        }
+    }
+    g->next_live[tile] = (alive != 0);
+    g->next_changed[tile] = (changed != 0);
+    if (s != NULL) {
+        for(size_t k=first; k<end; k++){
+            if (columns[k - first] != 0) {
+                box[1] = (box[1] < 0) ? (int)(k * WORD_BITS) + __builtin_ctzll(columns[k - first]) : box[1];
+                box[3] = (int)(k * WORD_BITS) + WORD_BITS - 1 - __builtin_clzll(columns[k - first]);
+            }
+        }
+        s->partials[id].births += counts[1];
+        s->partials[id].deaths += counts[2];
+        s->tile_population[tile] = (uint32_t)counts[0];
+        memcpy(s->tile_box + 4 * (size_t)tile, box, sizeof(box));
+    }
+}
+
+//One thread's share of a generation. The thread works through its own queue of tiles first, then steals tiles from the other threads until every queue is empty, so threads that were given quiet parts of the board help out with the busy parts. Every thread only reads from grid and only writes its own tiles of next_grid, so the cells just outside a tile (including the ones from the other side of the board when it wraps round) can be read freely. Nothing changes grid until every tile is finished, because pool_run() waits at the finish barrier.
+void step_tiles(void *arg, int id, int threads){
+    Grid_info *g = (Grid_info *)arg;
+    Deque *deques = g->pool->deques;
+    int tile, empty = 0;
     
-    printf("Grid 5 - Gun (40x40):\n");
-    equal_grids(g, grid5);
-    print_board(g);
+    while ((tile = deque_take(&deques[id])) >= 0) {
+        step_tile(g, tile, id);
+    }
+    while (empty == 0) {
+        empty = 1;
+        for(int v=1; v<threads; v++){
+            tile = deque_steal(&deques[(id + v) % threads]);
+            if (tile >= 0) {
+                step_tile(g, tile, id);
+            }
+            if (tile != -1) {
+                empty = 0;
+                break;
+            }
+        }
+    }
+}
+
+//Sets up a renderer showing the board from the cell at (top, left), fitting the window to the terminal (or to 80 by 24 characters if the output isn't a terminal), with one line left over at the bottom. If zoom is 0, the whole board is shown: as braille if it fits, and otherwise with the smallest zoom that makes it fit. It returns -1 if the memory could not be found.
+int render_init(Renderer *r, Grid_info *g, int top, int left, int zoom){
+    struct winsize size;
+    int lines = 24, width = 80;
     
-    printf("Please enter 1 for grid 1, 2 for grid 2 etc... :\n");
-    int x = input(1,5);
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 1 && size.ws_col > 0) {
+        lines = size.ws_row;
+        width = size.ws_col;
+    }
+    lines -= 1;
+    r->top = (top >= 0 && top < g->len) ? top : 0;
+    r->left = (left >= 0 && left < g->wid) ? left : 0;
+    if (zoom < 1) {
+        int across = (g->wid - r->left + width - 1) / width, down = (g->len - r->top + 2 * lines - 1) / (2 * lines);
+        zoom = (across > down) ? across : down;
+        zoom = (zoom <= 2) ? 1 : zoom;
+    }
+    r->zoom = zoom;
+    //A braille glyph covers 2 by 4 cells and a shaded one covers zoom by 2*zoom cells.
+    int cell_columns = (zoom == 1) ? 2 : zoom, cell_rows = (zoom == 1) ? 4 : 2 * zoom;
+    r->rows = (g->len - r->top + cell_rows - 1) / cell_rows;
+    r->columns = (g->wid - r->left + cell_columns - 1) / cell_columns;
+    r->rows = (r->rows < lines) ? r->rows : lines;
+    r->columns = (r->columns < width) ? r->columns : width;
+    //Each row of characters takes a cursor move of at most 16 bytes and 3 bytes of UTF-8 per character, and the frame ends with one more cursor move.
+    r->capacity = (size_t)r->rows * ((size_t)r->columns * 3 + 16) + 32;
+    r->buffer = (char *)malloc(r->capacity);
+    r->shown = (unsigned char *)malloc((size_t)r->rows * r->columns);
+    r->glyphs = (unsigned char *)malloc((size_t)r->rows * r->columns);
+    r->drawn = 0;
+    if (r->buffer == NULL || r->shown == NULL || r->glyphs == NULL) {
+        render_free(r);
+        return -1;
+    }
+    return 0;
+}
+
+//Frees the renderer's buffers.
+void render_free(Renderer *r){
+    free(r->buffer);
+    free(r->shown);
+    free(r->glyphs);
+    r->buffer = NULL;
+    r->shown = NULL;
+    r->glyphs = NULL;
+}
+
+//Works out the braille dots for the glyph whose top left cell is at (l, w). The dot for the cell x across and y down in a glyph is bit dots[y][x] of the character code after U+2800.
+static unsigned char braille_glyph(Grid_info *g, int l, int w){
+    static const unsigned char dots[4][2] = {{0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80}};
+    unsigned char glyph = 0;
+    for(int y=0; y<4 && l + y < g->len; y++){
+        for(int x=0; x<2 && w + x < g->wid; x++){
+            glyph |= cell(g, l + y, w + x) ? dots[y][x] : 0;
+        }
+    }
+    return glyph;
+}
+
+//Works out how full the block of zoom by 2*zoom cells whose top left cell is at (l, w) is, as a number from 0 (empty) to 9 (full). At most 4 by 4 cells spread evenly over the block are looked at, however big it is.
+static unsigned char density_glyph(Grid_info *g, int l, int w, int zoom){
+    int across = (zoom < 4) ? zoom : 4, down = (2 * zoom < 4) ? 2 * zoom : 4, alive = 0, samples = 0;
+    for(int y=0; y<down; y++){
+        int sample_l = l + (2 * zoom * y + zoom) / down;
+        for(int x=0; x<across && sample_l < g->len; x++){
+            int sample_w = w + (zoom * x + zoom / 2) / across;
+            if (sample_w < g->wid) {
+                alive += cell(g, sample_l, sample_w);
+                samples += 1;
+            }
+        }
+    }
+    return (unsigned char)((samples == 0) ? 0 : (alive * 9 + samples - 1) / samples);
+}
+
+//Works out the character for each place in the window, one byte each, into glyphs. Only the cells in the window (or the sampled cells, when zoomed out) are read.
+void render_glyphs(const Renderer *r, Grid_info *g, unsigned char *glyphs){
+    int cell_columns = (r->zoom == 1) ? 2 : r->zoom, cell_rows = (r->zoom == 1) ? 4 : 2 * r->zoom;
+    for(int row=0; row<r->rows; row++){
+        int l = r->top + row * cell_rows;
+        for(int c=0; c<r->columns; c++){
+            int w = r->left + c * cell_columns;
+            glyphs[(size_t)row * r->columns + c] = (r->zoom == 1) ? braille_glyph(g, l, w) : density_glyph(g, l, w, r->zoom);
+        }
+    }
+}
+
+//Builds a frame from the characters worked out by render_glyphs() in the renderer's buffer and returns its size in bytes. Only the rows that differ from what is already on screen go in the frame.
+size_t render_encode(Renderer *r, const unsigned char *glyphs){
+    static const char shades[] = " .:-=+*#%@";
+    char *out = r->buffer;
     
-    //After the user chooses a grid, the correct numbers from an array are entered into the structure.
-    if(x == 1){
-        g->len = 10;
-        g->wid = 10;
-        equal_grids(g, grid1);
+    if (r->drawn == 0) {
+        out += sprintf(out, "\x1b[2J");
+    }
+    for(int row=0; row<r->rows; row++){
+        unsigned char *shown = r->shown + (size_t)row * r->columns;
+        const unsigned char *next = glyphs + (size_t)row * r->columns;
+        if (r->drawn && memcmp(shown, next, (size_t)r->columns) == 0) {
+            continue;
+        }
+        memcpy(shown, next, (size_t)r->columns);
+        out += sprintf(out, "\x1b[%d;1H", row + 1);
+        for(int c=0; c<r->columns; c++){
+            if (r->zoom == 1) {
+                *out++ = (char)0xE2;
+                *out++ = (char)(0xA0 | (shown[c] >> 6));
+                *out++ = (char)(0x80 | (shown[c] & 0x3F));
+            }
+            else{
+                *out++ = shades[shown[c]];
+            }
+        }
     }
-    if(x == 2){
-        g->len = 10;
-        g->wid = 10;
-        equal_grids(g, grid2);
+    out += sprintf(out, "\x1b[%d;1H", r->rows + 1);
+    r->drawn = 1;
+    return (size_t)(out - r->buffer);
+}
+
+//Builds a frame of the window in the renderer's buffer and returns its size in bytes.
+size_t render_frame(Renderer *r, Grid_info *g){
+    render_glyphs(r, g, r->glyphs);
+    return render_encode(r, r->glyphs);
+}
+
+//Sends the first size bytes of the renderer's buffer to the terminal with one write() (more only if the terminal takes it in pieces).
+void render_write(Renderer *r, size_t size){
+    fflush(stdout);
+    for(size_t done = 0; done < size;){
+        ssize_t wrote = write(STDOUT_FILENO, r->buffer + done, size - done);
+        if (wrote <= 0) {
+            break;
+        }
+        done += (size_t)wrote;
     }
-    if(x == 3){
-        g->len = 40;
-        g->wid = 40;
-        equal_grids(g, grid3);
+}
+
+//Draws the board on the terminal.
+void render_draw(Renderer *r, Grid_info *g){
+    render_write(r, render_frame(r, g));
+}
+
+//The live view thread. It asks for a frame, waits for it to come through the ring, draws the newest one there (dropping any that came before it) and then waits long enough to keep to GOL_FPS frames a second, until it is told to quit and the ring is empty.
+static void *view_worker(void *arg){
+    Live_view *v = (Live_view *)arg;
+    Frame_ring *ring = &v->ring;
+    
+    while (1) {
+        size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (head == tail) {
+            if (atomic_load_explicit(&v->quit, memory_order_acquire) && atomic_load_explicit(&ring->head, memory_order_acquire) == tail) {
+                break;
+            }
+            usleep(1000);
+            continue;
+        }
+        size_t newest = (head - 1) % RING_SLOTS;
+        uint64_t generation = ring->generation[newest];
+        if (v->drawn > 0 && generation > v->shown) {
+            v->skipped += (long)(generation - v->shown - 1);
+        }
+        v->shown = generation;
+        size_t size = render_encode(&v->renderer, ring->slots + newest * ring->slot_bytes);
+        atomic_store_explicit(&ring->tail, head, memory_order_release);
+        render_write(&v->renderer, size);
+        v->drawn += 1;
+        usleep((useconds_t)(1000000 / v->fps));
+        atomic_store_explicit(&ring->wanted, 1, memory_order_release);
     }
-    if(x == 4){
-        g->len = 40;
-        g->wid = 40;
-        equal_grids(g, grid4);
+    return NULL;
+}
+
+//Starts a live view of the window of the board described by top, left and zoom (see render_init()). It returns -1 if the memory could not be found or the thread could not be started.
+int view_start(Live_view *v, Grid_info *g, int top, int left, int zoom){
+    memset(v, 0, sizeof(Live_view));
+    if (render_init(&v->renderer, g, top, left, zoom) != 0) {
+        return -1;
     }
-    if(x == 5){
-        g->len = 40;
-        g->wid = 40;
-        equal_grids(g, grid5);
+    v->fps = frames_per_second();
+    v->ring.slot_bytes = (size_t)v->renderer.rows * v->renderer.columns;
+    v->ring.slots = (unsigned char *)malloc(RING_SLOTS * v->ring.slot_bytes);
+    atomic_init(&v->ring.head, 0);
+    atomic_init(&v->ring.tail, 0);
+    atomic_init(&v->ring.wanted, 1);
+    atomic_init(&v->quit, 0);
+    if (v->ring.slots == NULL || pthread_create(&v->thread, NULL, view_worker, v) != 0) {
+        free(v->ring.slots);
+        render_free(&v->renderer);
+        return -1;
     }
+    return 0;
+}
+
+//Offers the board to the live view. Unless the view has asked for a frame the board isn't sampled at all, which costs one atomic load, so the board is only sampled as often as the view draws it. If wait is set the frame is sent whether it was asked for or not, waiting for room in the ring if need be, which is used for the last frame of a run.
+void view_offer(Live_view *v, Grid_info *g, int wait){
+    Frame_ring *ring = &v->ring;
+    
+    if (wait == 0) {
+        if (atomic_load_explicit(&ring->wanted, memory_order_acquire) == 0) {
+            return;
+        }
+        atomic_store_explicit(&ring->wanted, 0, memory_order_relaxed);
+    }
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    while (head - atomic_load_explicit(&ring->tail, memory_order_acquire) == RING_SLOTS) {
+        usleep(1000);
+    }
+    render_glyphs(&v->renderer, g, ring->slots + (head % RING_SLOTS) * ring->slot_bytes);
+    ring->generation[head % RING_SLOTS] = g->generation;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+//Shows the final board, waits for the view to draw it and stops the thread.
+void view_stop(Live_view *v, Grid_info *g){
+    view_offer(v, g, 1);
+    atomic_store_explicit(&v->quit, 1, memory_order_release);
+    pthread_join(v->thread, NULL);
+    free(v->ring.slots);
+    render_free(&v->renderer);
+}
+
+//The number of frames a second the renderer shows in the game. It defaults to 10 and can be set with the GOL_FPS environment variable.
+int frames_per_second(void){
+    const char *fps = getenv("GOL_FPS");
+    if (fps != NULL && atoi(fps) > 0) {
+        return atoi(fps);
+    }
+    return 10;
+}
+
+//This function calculates the next grid with the word-at-a-time kernel, stepping only the tiles that can change. A cell can only change if something in the 3x3 block around it changed last generation, so a tile only needs stepping if it or one of the eight tiles around it changed, and also has a live cell somewhere in that block (otherwise nothing in it can be born). The tiles that do need stepping are shared out between the threads' queues in runs of neighbouring tiles.
+//A skipped tile stays as it is. If it didn't change last generation its part of next_grid already matches grid. If it is dead it may still hold live cells from an earlier generation in next_grid, and only then does it need clearing. When cells have been put into grid directly, every tile is stepped because the flags don't match the board yet. If statistics are being counted, the threads' counts are added up once every tile has been stepped.
+void next(Grid_info *g){
+    int count = 0, tiles = g->tiles_down * g->tiles_across;
+    int threads = (g->pool == NULL) ? 1 : g->pool->threads;
+    
+    //On an unbounded plane the plane is stepped instead, and next_grid shows the part of it under the board.
+    if (g->plane != NULL) {
+        sparse_step(g->plane, g->pool);
+        sparse_view(g->plane, g, g->next_grid);
+        return;
+    }
+    for(int t=0; t<tiles; t++){
+        int down = t / g->tiles_across, across = t % g->tiles_across;
+        int changed = !g->tiles_known, alive = !g->tiles_known;
+        for(int i=-1; i<=1 && (changed == 0 || alive == 0); i++){
+            for(int j=-1; j<=1; j++){
+                int near = ((down + i + g->tiles_down) % g->tiles_down) * g->tiles_across + (across + j + g->tiles_across) % g->tiles_across;
+                changed |= g->changed[near];
+                alive |= g->live[near];
+            }
+        }
+        if (changed && alive) {
+            g->active[count++] = t;
+            continue;
+        }
+        if (g->live[t] == 0 && g->next_live[t]) {
+            int first_row = down * TILE_ROWS, end_row = (first_row + TILE_ROWS < g->len) ? first_row + TILE_ROWS : g->len;
+            for(int l=first_row; l<end_row; l++){
+                memset(g->next_grid + (size_t)l * g->stride + (size_t)across * TILE_WORDS, 0, TILE_WORDS * sizeof(uint64_t));
+            }
+        }
+        g->next_live[t] = g->live[t];
+        g->next_changed[t] = 0;
+    }
+    g->active_count = count;
+    
+    if (threads == 1 || count == 1) {
+        for(int i=0; i<count; i++){
+            step_tile(g, g->active[i], 0);
+        }
+    }
+    else{
+        for(int i=0; i<threads; i++){
+            g->pool->deques[i].items = g->active;
+            atomic_store(&g->pool->deques[i].top, (long)count * i / threads);
+            atomic_store(&g->pool->deques[i].bottom, (long)count * (i + 1) / threads);
+        }
+        pool_run(g->pool, step_tiles, g);
+    }
+    if (g->stats != NULL) {
+        stats_gather(g->stats, g);
+    }
+}
+
+//Readies the grid for the next iteration by swapping grid and next_grid, along with their tile flags, so nothing is copied. This leaves the board from the generation before in next_grid, which is what next() expects: a tile it skips either didn't change last generation (so that board already matches) or is dead and gets cleared. If the cells had been put into grid directly, nothing is known about which of its tiles are alive, so they are all marked alive to make sure none of them is left uncleared.
+void advance(Grid_info *g){
+    uint64_t *board = g->grid;
+    unsigned char *flags = g->live;
+    
+    g->grid = g->next_grid;
+    g->next_grid = board;
+    g->live = g->next_live;
+    g->next_live = flags;
+    flags = g->changed;
+    g->changed = g->next_changed;
+    g->next_changed = flags;
+    if (g->tiles_known == 0) {
+        memset(g->next_live, 1, (size_t)(g->tiles_down * g->tiles_across));
+    }
+    g->active_count = 0;
+    g->tiles_known = (g->plane == NULL);
+    g->generation += 1;
+}
+
+//Returns 1 if anything changed in the generation that next() just worked out. Only the tiles that were stepped can have changed, and step_tile() has already recorded which of them did, so this doesn't need to look at the cells.
+int board_changed(Grid_info *g){
+    if (g->plane != NULL) {
+        return g->plane->changed;
+    }
+    for(int i=0; i<g->active_count; i++){
+        if (g->next_changed[g->active[i]]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//Mixes word value, found at index in the board, into the value it adds to the board's hash. Empty words add nothing, so only the words with live cells need hashing. The mixing is the finaliser from splitmix64, which spreads every bit of its input over the whole output.
+static inline uint64_t hash_word(size_t index, uint64_t value){
+    if (value == 0) {
+        return 0;
+    }
+    uint64_t z = value ^ ((uint64_t)index * 0x9e3779b97f4a7c15u);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+    return z ^ (z >> 31);
+}
+
+//Works out the hash of a board from scratch.
+uint64_t board_hash(Grid_info *g, const uint64_t *board){
+    uint64_t hash = 0;
+    for(size_t i=0; i<(size_t)g->len * g->stride; i++){
+        hash ^= hash_word(i, board[i]);
+    }
+    return hash;
+}
+
+//Works out the hash of the generation next() just put in next_grid from the hash of grid. Only the tiles that next() stepped and found changed can differ between the two boards, and in those only the words that differ need hashing again. The padding past the end of each row is always empty, so it isn't looked at.
+uint64_t hash_update(Grid_info *g, uint64_t hash){
+    size_t words = ((size_t)g->wid + WORD_BITS - 1) / WORD_BITS;
+    for(int i=0; i<g->active_count; i++){
+        int t = g->active[i];
+        if (g->next_changed[t] == 0) {
+            continue;
+        }
+        int down = t / g->tiles_across, across = t % g->tiles_across;
+        int first_row = down * TILE_ROWS, end_row = (first_row + TILE_ROWS < g->len) ? first_row + TILE_ROWS : g->len;
+        size_t tile_words = (words - (size_t)across * TILE_WORDS < TILE_WORDS) ? words - (size_t)across * TILE_WORDS : TILE_WORDS;
+        for(int l=first_row; l<end_row; l++){
+            size_t first = (size_t)l * g->stride + (size_t)across * TILE_WORDS;
+            for(size_t k=first; k<first+tile_words; k++){
+                if (g->grid[k] != g->next_grid[k]) {
+                    hash ^= hash_word(k, g->grid[k]) ^ hash_word(k, g->next_grid[k]);
+                }
+            }
+        }
+    }
+    return hash;
+}
+
+//Sets up a history that remembers size generations. It returns -1 if the memory could not be found.
+int history_init(History *h, size_t size){
+    memset(h, 0, sizeof(History));
+    h->size = size;
+    h->slots = 1;
+    while (h->slots < 2 * size) {
+        h->slots *= 2;
+    }
+    h->ring = (uint64_t *)malloc(size * sizeof(uint64_t));
+    h->keys = (uint64_t *)malloc(h->slots * sizeof(uint64_t));
+    h->generations = (uint64_t *)malloc(h->slots * sizeof(uint64_t));
+    if (h->ring == NULL || h->keys == NULL || h->generations == NULL) {
+        history_free(h);
+        return -1;
+    }
+    return 0;
+}
+
+void history_free(History *h){
+    free(h->ring);
+    free(h->keys);
+    free(h->generations);
+    h->ring = NULL;
+    h->keys = NULL;
+    h->generations = NULL;
+}
+
+//Forgets everything and starts again from the board as it is now. This has to be called whenever the board is changed other than by stepping it.
+void history_start(History *h, Grid_info *g){
+    for(size_t i=0; i<h->slots; i++){
+        h->generations[i] = UINT64_MAX;
+    }
+    h->first = g->generation;
+    h->count = 0;
+    h->hash = board_hash(g, g->grid);
+    history_add(h, h->hash, g->generation);
+}
+
+//Finds the slot holding hash, or the empty slot where it would go.
+static size_t history_slot(const History *h, uint64_t hash){
+    size_t mask = h->slots - 1, i = (size_t)hash & mask;
+    while (h->generations[i] != UINT64_MAX && h->keys[i] != hash) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+//Records the hash of generation. The hash of the generation that has now dropped out of the ring is taken out of the table, and the entries after it are moved back into the gap so every entry can still be found from its own slot. It returns the generation the same hash was last seen at, if that was within the last size generations, or UINT64_MAX if it wasn't.
+uint64_t history_add(History *h, uint64_t hash, uint64_t generation){
+    size_t mask = h->slots - 1;
+    
+    if (h->count >= h->size) {
+        uint64_t old = generation - h->size;
+        size_t i = history_slot(h, h->ring[old % h->size]);
+        if (h->generations[i] == old) {
+            h->generations[i] = UINT64_MAX;
+            for(size_t j=(i + 1) & mask; h->generations[j] != UINT64_MAX; j=(j + 1) & mask){
+                size_t home = (size_t)h->keys[j] & mask;
+                if (((j - home) & mask) >= ((j - i) & mask)) {
+                    h->keys[i] = h->keys[j];
+                    h->generations[i] = h->generations[j];
+                    h->generations[j] = UINT64_MAX;
+                    i = j;
+                }
+            }
+        }
+    }
+    size_t i = history_slot(h, hash);
+    uint64_t seen = h->generations[i];
+    h->keys[i] = hash;
+    h->generations[i] = generation;
+    h->ring[generation % h->size] = hash;
+    h->count += 1;
+    return seen;
+}
+
+//Brings the hash up to date with the generation next() just worked out and records it. If the new generation has been seen before within the history, the board is going round in a cycle: the period is returned and start is set to the generation the cycle started at (the first generation of it that came round again). It returns 0 otherwise, and always on an unbounded plane, where the board is only a window onto the pattern.
+uint64_t history_step(History *h, Grid_info *g, uint64_t *start){
+    if (g->plane != NULL) {
+        return 0;
+    }
+    h->hash = hash_update(g, h->hash);
+    uint64_t seen = history_add(h, h->hash, g->generation + 1);
+    if (seen == UINT64_MAX) {
+        return 0;
+    }
+    *start = seen;
+    return g->generation + 1 - seen;
+}
+
+//Starts counting statistics of the board as it is stepped. s is set up for the board's present size and thread pool, and has to be started again if either changes. The statistics of the board as it is now are worked out from scratch, and the tiles are marked as not known so the next generation steps every tile and fills in its count and box. It returns -1 if the memory could not be found.
+int stats_init(Board_stats *s, Grid_info *g){
+    size_t words = ((size_t)g->wid + WORD_BITS - 1) / WORD_BITS;
+    void *partials;
+    
+    s->tiles = g->tiles_down * g->tiles_across;
+    s->threads = (g->pool == NULL) ? 1 : g->pool->threads;
+    s->tile_population = (uint32_t *)malloc((size_t)s->tiles * sizeof(uint32_t));
+    s->tile_box = (int *)malloc(4 * (size_t)s->tiles * sizeof(int));
+    s->partials = (posix_memalign(&partials, ROW_ALIGN_WORDS * sizeof(uint64_t), (size_t)s->threads * sizeof(Stat_partial)) == 0) ? (Stat_partial *)partials : NULL;
+    if (s->tile_population == NULL || s->tile_box == NULL || s->partials == NULL) {
+        free(s->tile_population);
+        free(s->tile_box);
+        free(s->partials);
+        return -1;
+    }
+    memset(s->partials, 0, (size_t)s->threads * sizeof(Stat_partial));
+    s->population = population(g);
+    s->births = 0;
+    s->deaths = 0;
+    for(int i=0; i<4; i++){
+        s->box[i] = -1;
+        s->written[i] = -1;
+    }
+    for(int l=0; l<g->len; l++){
+        for(size_t k=0; k<words; k++){
+            uint64_t value = g->grid[(size_t)l * g->stride + k];
+            if (value == 0) {
+                continue;
+            }
+            int left = (int)(k * WORD_BITS) + __builtin_ctzll(value), right = (int)(k * WORD_BITS) + WORD_BITS - 1 - __builtin_clzll(value);
+            s->box[0] = (s->box[0] < 0) ? l : s->box[0];
+            s->box[1] = (s->box[1] < 0 || left < s->box[1]) ? left : s->box[1];
+            s->box[2] = l;
+            s->box[3] = (right > s->box[3]) ? right : s->box[3];
+        }
+    }
+    g->stats = s;
+    g->tiles_known = 0;
+    return 0;
+}
+
+//Stops counting statistics and frees their memory.
+void stats_free(Board_stats *s, Grid_info *g){
+    free(s->tile_population);
+    free(s->tile_box);
+    free(s->partials);
+    s->tile_population = NULL;
+    s->tile_box = NULL;
+    s->partials = NULL;
+    g->stats = NULL;
+}
+
+//Adds up the statistics of the generation next() just worked out, once every tile has been stepped: the births and deaths from each thread's partial (which are cleared for the next generation), and the population and box from the tiles that are alive in next_grid.
+void stats_gather(Board_stats *s, Grid_info *g){
+    s->births = 0;
+    s->deaths = 0;
+    for(int i=0; i<s->threads; i++){
+        s->births += s->partials[i].births;
+        s->deaths += s->partials[i].deaths;
+        s->partials[i].births = 0;
+        s->partials[i].deaths = 0;
+    }
+    s->population = 0;
+    for(int i=0; i<4; i++){
+        s->box[i] = -1;
+    }
+    for(int t=0; t<s->tiles; t++){
+        const int *box = s->tile_box + 4 * (size_t)t;
+        if (g->next_live[t] == 0 || box[0] < 0) {
+            continue;
+        }
+        s->population += s->tile_population[t];
+        s->box[0] = (s->box[0] < 0 || box[0] < s->box[0]) ? box[0] : s->box[0];
+        s->box[1] = (s->box[1] < 0 || box[1] < s->box[1]) ? box[1] : s->box[1];
+        s->box[2] = (box[2] > s->box[2]) ? box[2] : s->box[2];
+        s->box[3] = (box[3] > s->box[3]) ? box[3] : s->box[3];
+    }
+}
+
+//This function lets the user create their own starting grid, each position at a time. This is a slow process but works decently for grids smaller than 10x10.
+void custom(Grid_info *g){
+    printf("\nPlease enter your values in for your custom board - 0 is dead, 1 is alive a:\n");
+    for (int l=0 ; l < g->len ; l++){
+        for (int w=0 ; w < g->wid ; w++){
+            printf("Please enter your input for the [%d][%d] position:\n",l,w);
+            set_cell(g->grid, g->stride, l, w, input(0,1));
+        }
+    }
+}
+
+//This function weaves all the other functions together and takes the correct steps for each iteration of the game. The game will stop if there is no change between iterations, or if the board starts going round a cycle of generations it has already been through (see History).
+void run(int iterations, Grid_info *g){
+    int j=0, stop=0;
+    uint64_t period = 0, start = 0;
+    Renderer r;
+    History history;
+    int cycles = history_init(&history, CYCLE_HISTORY) == 0;
+    if (cycles) {
+        history_start(&history, g);
+    }
+    //On a terminal the board is drawn with the fast renderer at GOL_FPS frames a second. When the output is going somewhere else (a file or another program) it is printed as text once a second as before.
+    int fast = isatty(STDOUT_FILENO) && render_init(&r, g, 0, 0, 0) == 0;
+    while (j<iterations && stop == 0){
+        next(g);
+        if (fast) {
+            render_draw(&r, g);
+            usleep((useconds_t)(1000000 / frames_per_second()));
+        }
+        else{
+            print_board(g);
+            sleep(1);
+            printf("\n\n\n\n\n\n\n\n\n\n\n\n");
+        }
+        
+        //Check if boards are identical between iterations. The kernel keeps track of which tiles changed as it goes, so there is no need to compare the boards.
+        if (cycles) {
+            period = history_step(&history, g, &start);
+        }
+        if (board_changed(g) == 0){
+            printf("No change in grid so game will stop.\n");
+            stop = 1;
+        }
+        else if (period > 0) {
+            printf("The grid repeats every %llu generations from generation %llu so game will stop.\n", (unsigned long long)period, (unsigned long long)start);
+            stop = 1;
+        }
+        
+        // Readying grid for next interation
+        advance(g);
+        j += 1;
+    }
+    if (fast) {
+        render_free(&r);
+    }
+    if (cycles) {
+        history_free(&history);
+    }
+}
+
+//This function reads a board from a plain text file of 0s and 1s separated by spaces, with one row of the board on each line. The size of the board is taken from the file: the width is the number of values on the first line and the length is the number of lines. The file is read twice, once to find the size and once to put the cells straight into the board. It returns -1 if the file could not be read or the memory could not be found.
+int load_text(Grid_info *g, const char *path){
+    FILE *file = fopen(path, "r");
+    int len = 0, wid = 0, values = 0, c, previous = ' ', value;
+    
+    if (file == NULL) {
+        printf("Could not open %s\n", path);
+        return -1;
+    }
+    //First pass - counts the values on the first line and the number of lines that have any values on them.
+    while ((c = getc(file)) != EOF) {
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n' && (previous == ' ' || previous == '\t' || previous == '\n')) {
+            values += 1;
+        }
+        if (c == '\n' || (c == EOF)) {
+            if (values > 0) {
+                if (len == 0) {
+                    wid = values;
+                }
+                len += 1;
+            }
+            values = 0;
+        }
+        previous = c;
+    }
+    if (values > 0) {
+        if (len == 0) {
+            wid = values;
+        }
+        len += 1;
+    }
+    if (len == 0 || grid_resize(g, len, wid) != 0) {
+        printf("Could not make a board from %s\n", path);
+        fclose(file);
+        return -1;
+    }
+    
+    //Second pass - reads the cells into the board.
+    rewind(file);
+    for(int l=0; l<len; l++){
+        for(int w=0; w<wid; w++){
+            if (fscanf(file, "%i", &value) != 1) {
+                printf("%s ends part way through row %d\n", path, l);
+                fclose(file);
+                return -1;
+            }
+            set_cell(g->grid, g->stride, l, w, value != 0);
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+//Writes the board to a plain text file in the same format that load_text() reads. It returns -1 if the file could not be written.
+int save_text(Grid_info *g, const char *path){
+    FILE *file = fopen(path, "w");
+    
+    if (file == NULL) {
+        printf("Could not open %s\n", path);
+        return -1;
+    }
+    for(int l=0; l<g->len; l++){
+        for(int w=0; w<g->wid; w++){
+            putc('0' + cell(g, l, w), file);
+            putc((w + 1 < g->wid) ? ' ' : '\n', file);
+        }
+    }
+    if (fclose(file) != 0) {
+        printf("Could not write %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+//Sets count cells of a row alive from column w onwards, a word at a time.
+static void set_run(uint64_t *row, int w, int count){
+    while (count > 0) {
+        int bit = w % WORD_BITS, take = (WORD_BITS - bit < count) ? WORD_BITS - bit : count;
+        row[w / WORD_BITS] |= ((take == WORD_BITS) ? ~(uint64_t)0 : ((uint64_t)1 << take) - 1) << bit;
+        w += take;
+        count -= take;
+    }
+}
+
+//This function reads a board in the Run Length Encoded (.rle) format used by most pattern collections. Lines starting with # are comments, then a header line gives the size as "x = width, y = length" and maybe a rule, which becomes the rule the board is run with, then the cells follow as runs: a count (1 if left out) and b for dead cells, o for live ones (any other letter counts as alive too), $ for the end of a row and ! for the end of the pattern. The file is read one character at a time and the runs are put straight into the board, so the pattern is never held in memory twice. It returns -1 if the file could not be read or the memory could not be found.
+int load_rle(Grid_info *g, const char *path){
+    FILE *file = fopen(path, "r");
+    char line[4096], *header;
+    int len = 0, wid = 0, l = 0, w = 0, c;
+    long count = 0;
+    
+    if (file == NULL) {
+        printf("Could not open %s\n", path);
+        return -1;
+    }
+    while ((header = fgets(line, sizeof(line), file)) != NULL && line[0] == '#') {
+        while (strchr(line, '\n') == NULL && fgets(line, sizeof(line), file) != NULL) {
+        }
+    }
+    //A file that is empty or only comments has no header line to read.
+    if (header == NULL || sscanf(line, " x = %d , y = %d", &wid, &len) != 2) {
+        printf("Could not make a board from %s\n", path);
+        fclose(file);
+        return -1;
+    }
+    //The rule is checked before the board is touched, so a file with a bad rule leaves the board as it was.
+    char *rule = strstr(line, "rule"), name[32] = "";
+    Rule parsed;
+    if (rule != NULL && (sscanf(strchr(rule, '=') != NULL ? strchr(rule, '=') + 1 : rule, " %31[^ ,\t\r\n]", name) != 1 || parse_rule(&parsed, name) != 0)) {
+        printf("Could not make a board from %s: \"%s\" is not a rule this program can run\n", path, name);
+        fclose(file);
+        return -1;
+    }
+    if (grid_resize(g, len, wid) != 0) {
+        printf("Could not make a board from %s\n", path);
+        fclose(file);
+        return -1;
+    }
+    if (rule != NULL) {
+        set_rule(name);
+    }
+    
+    while ((c = getc(file)) != EOF && c != '!') {
+        if (c >= '0' && c <= '9') {
+            count = count * 10 + (c - '0');
+            if (count > MAX_DIMENSION) {
+                break;
+            }
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            continue;
+        }
+        if (count == 0) {
+            count = 1;
+        }
+        //The runs are checked against the size as they go, so a long run can't carry l or w past the board (or round past the largest int).
+        if (c == '$') {
+            l += (int)count;
+            w = 0;
+            if (l > len) {
+                break;
+            }
+        }
+        else if (c == 'b' || c == '.') {
+            w += (int)count;
+            if (w > wid) {
+                break;
+            }
+        }
+        else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+            if (l >= len || w + count > wid) {
+                break;
+            }
+            set_run(g->grid + (size_t)l * g->stride, w, (int)count);
+            w += (int)count;
+        }
+        else{
+            break;
+        }
+        count = 0;
+    }
+    fclose(file);
+    if (c != '!') {
+        printf("%s has cells outside its size or isn't a valid pattern (row %d)\n", path, l);
+        return -1;
+    }
+    return 0;
+}
+
+//Returns how many cells in a row starting at column w have the same state as value, up to the end of the row. The row is scanned a word at a time for the first bit that differs.
+static int run_length(const uint64_t *row, int w, int wid, int value){
+    size_t words = ((size_t)wid + WORD_BITS - 1) / WORD_BITS;
+    uint64_t flip = value ? ~(uint64_t)0 : 0;
+    
+    for(size_t k = (size_t)w / WORD_BITS; k<words; k++){
+        uint64_t differ = row[k] ^ flip;
+        if (k == (size_t)w / WORD_BITS) {
+            differ &= ~(uint64_t)0 << (w % WORD_BITS);
+        }
+        if (differ != 0) {
+            int end = (int)(k * WORD_BITS) + __builtin_ctzll(differ);
+            return ((end < wid) ? end : wid) - w;
+        }
+    }
+    return wid - w;
+}
+
+//Adds one run to an RLE file, starting a new line before the line would go past 70 characters as the format asks.
+static void put_run(FILE *file, long count, char tag, int *column){
+    char run[24];
+    int size = (count > 1) ? snprintf(run, sizeof(run), "%ld%c", count, tag) : snprintf(run, sizeof(run), "%c", tag);
+    if (*column + size > 70) {
+        putc('\n', file);
+        *column = 0;
+    }
+    fputs(run, file);
+    *column += size;
+}
+
+//Writes the board as a Run Length Encoded (.rle) file. Dead cells at the end of a row are left out and runs of empty rows are joined into one $, so a sparse board gives a small file. It returns -1 if the file could not be written.
+int save_rle(Grid_info *g, const char *path){
+    FILE *file = fopen(path, "w");
+    int column = 0;
+    long rows = 0;
+    
+    if (file == NULL) {
+        printf("Could not open %s\n", path);
+        return -1;
+    }
+    fprintf(file, "x = %d, y = %d, rule = %s\n", g->wid, g->len, life_rule.name);
+    for(int l=0; l<g->len; l++){
+        const uint64_t *row = g->grid + (size_t)l * g->stride;
+        int w = 0;
+        while (w < g->wid) {
+            int value = (row[w / WORD_BITS] >> (w % WORD_BITS)) & 1;
+            int run = run_length(row, w, g->wid, value);
+            if (value == 0 && w + run == g->wid) {
+                break;
+            }
+            if (rows > 0) {
+                put_run(file, rows, '$', &column);
+                rows = 0;
+            }
+            put_run(file, run, value ? 'o' : 'b', &column);
+            w += run;
+        }
+        rows += 1;
+    }
+    fputs("!\n", file);
+    if (fclose(file) != 0) {
+        printf("Could not write %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+//Writes value into out as a varint, in the same way as put_varint(), and returns the number of bytes it took.
+static size_t pack_varint(unsigned char *out, uint64_t value){
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (unsigned char)value;
+    return n;
+}
+
+//Reads a varint from in without going past end. It returns the number of bytes read, or 0 if the varint runs off the end or is too long.
+static size_t unpack_varint(const unsigned char *in, const unsigned char *end, uint64_t *value){
+    *value = 0;
+    for(size_t n=0; n<10 && in + n < end; n++){
+        *value |= (uint64_t)(in[n] & 0x7f) << (7 * n);
+        if ((in[n] & 0x80) == 0) {
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+//Works out where block b lies on the board: its first row and word, and how many rows and words it covers (fewer than a full block on the bottom and right edges).
+static void block_bounds(const Grid_info *g, int blocks_across, int b, int *row, int *rows, size_t *word, size_t *words){
+    size_t row_words = ((size_t)g->wid + WORD_BITS - 1) / WORD_BITS;
+    *row = (b / blocks_across) * BLOCK_ROWS;
+    *rows = (g->len - *row < BLOCK_ROWS) ? g->len - *row : BLOCK_ROWS;
+    *word = (size_t)(b % blocks_across) * BLOCK_WORDS;
+    *words = (row_words - *word < BLOCK_WORDS) ? row_words - *word : BLOCK_WORDS;
+}
+
+//Finds word i of a block, counting across each row of the block and then down.
+static inline uint64_t *block_word(const Grid_info *g, int row, size_t word, size_t words, size_t i){
+    return g->grid + (size_t)(row + (int)(i / words)) * g->stride + word + i % words;
+}
+
+//Compresses one block into out and returns its size. The words of the block are taken a row at a time, and written as a run of empty words followed by a run of words with cells in them, over and over: each pair starts with the two run lengths as varints, and each word in the second run is a byte with a bit set for each of its bytes that isn't zero, followed by just those bytes. A block that would come out bigger than its words is stored as they are instead. The first byte says which was done (1 for runs, 0 for the words as they are).
+static size_t pack_block(const Grid_info *g, int blocks_across, int b, unsigned char *out){
+    int row, rows;
+    size_t word, words, count, raw, n = 1, i = 0;
+    
+    block_bounds(g, blocks_across, b, &row, &rows, &word, &words);
+    count = (size_t)rows * words;
+    raw = count * sizeof(uint64_t);
+    while (i < count && n <= raw) {
+        size_t zeros = 0, literals = 0;
+        while (i + zeros < count && *block_word(g, row, word, words, i + zeros) == 0) {
+            zeros += 1;
+        }
+        while (i + zeros + literals < count && *block_word(g, row, word, words, i + zeros + literals) != 0) {
+            literals += 1;
+        }
+        n += pack_varint(out + n, zeros);
+        n += pack_varint(out + n, literals);
+        i += zeros;
+        for(size_t end=i+literals; i<end && n <= raw; i++){
+            uint64_t value = *block_word(g, row, word, words, i);
+            unsigned char *mask = out + n++;
+            *mask = 0;
+            for(int k=0; k<8; k++){
+                if ((value >> (8 * k)) & 0xff) {
+                    *mask |= (unsigned char)(1 << k);
+                    out[n++] = (unsigned char)(value >> (8 * k));
+                }
+            }
+        }
+    }
+    if (n <= raw) {
+        out[0] = 1;
+        return n;
+    }
+    out[0] = 0;
+    for(int l=0; l<rows; l++){
+        memcpy(out + 1 + (size_t)l * words * sizeof(uint64_t), g->grid + (size_t)(row + l) * g->stride + word, words * sizeof(uint64_t));
+    }
+    return 1 + raw;
+}
+
+//Uncompresses one block of size bytes, written by pack_block(), into the board. It returns -1 if the block doesn't hold exactly the cells of its part of the board.
+static int unpack_cells(Grid_info *g, int blocks_across, int b, const unsigned char *in, size_t size){
+    const unsigned char *end = in + size;
+    int row, rows;
+    size_t word, words, count, i = 0;
+    uint64_t zeros, literals;
+    
+    block_bounds(g, blocks_across, b, &row, &rows, &word, &words);
+    count = (size_t)rows * words;
+    if (size == 0) {
+        return -1;
+    }
+    if (in[0] == 0) {
+        if (size != 1 + count * sizeof(uint64_t)) {
+            return -1;
+        }
+        for(int l=0; l<rows; l++){
+            memcpy(g->grid + (size_t)(row + l) * g->stride + word, in + 1 + (size_t)l * words * sizeof(uint64_t), words * sizeof(uint64_t));
+        }
+        return 0;
+    }
+    in += 1;
+    while (i < count) {
+        size_t n = unpack_varint(in, end, &zeros), m = (n == 0) ? 0 : unpack_varint(in + n, end, &literals);
+        if (m == 0 || zeros > count - i || literals > count - i - zeros) {
+            return -1;
+        }
+        in += n + m;
+        for(size_t end_zeros=i+zeros; i<end_zeros; i++){
+            *block_word(g, row, word, words, i) = 0;
+        }
+        for(size_t end_literals=i+literals; i<end_literals; i++){
+            uint64_t value = 0;
+            if (in >= end) {
+                return -1;
+            }
+            unsigned char mask = *in++;
+            for(int k=0; k<8; k++){
+                if ((mask >> k) & 1) {
+                    if (in >= end) {
+                        return -1;
+                    }
+                    value |= (uint64_t)*in++ << (8 * k);
+                }
+            }
+            *block_word(g, row, word, words, i) = value;
+        }
+    }
+    return (in == end) ? 0 : -1;
+}
+
+//Packs this thread's share of the blocks, taking every threads'th block.
+static void pack_blocks(void *arg, int id, int threads){
+    Pack_job *job = (Pack_job *)arg;
+    for(int b=id; b<job->blocks; b+=threads){
+        job->sizes[b] = pack_block(job->g, job->blocks_across, b, job->data + (size_t)b * BLOCK_BOUND);
+    }
+}
+
+//Unpacks one block with unpack_cells(), and then, if the block reaches the right hand edge of the board, checks that no cells past the width of the board were stored in it. Those bits must always be zero (the kernels and the board hash rely on it), so a block that has any is damaged.
+static int unpack_block(Grid_info *g, int blocks_across, int b, const unsigned char *in, size_t size){
+    size_t row_words = ((size_t)g->wid + WORD_BITS - 1) / WORD_BITS, word, words;
+    int row, rows, last = (g->wid - 1) % WORD_BITS;
+    uint64_t outside = (last == WORD_BITS - 1) ? 0 : ~(((uint64_t)1 << (last + 1)) - 1);
+    
+    if (unpack_cells(g, blocks_across, b, in, size) != 0) {
+        return -1;
+    }
+    block_bounds(g, blocks_across, b, &row, &rows, &word, &words);
+    for(int l=row; l<row+rows && word + words == row_words; l++){
+        if (g->grid[(size_t)l * g->stride + row_words - 1] & outside) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+//Unpacks this thread's share of the blocks, taking every threads'th block.
+static void unpack_blocks(void *arg, int id, int threads){
+    Pack_job *job = (Pack_job *)arg;
+    for(int b=id; b<job->blocks; b+=threads){
+        if (unpack_block(job->g, job->blocks_across, b, job->data + job->offsets[b], (size_t)(job->offsets[b + 1] - job->offsets[b])) != 0) {
+            atomic_store(&job->failed, 1);
+        }
+    }
+}
+
+//Writes the board to a compressed snapshot (see SNAPSHOT_PACKED). The blocks are packed on the board's thread pool if it has one, and written out in order after the index. It returns -1 if the file could not be written or the memory could not be found.
+int save_packed(Grid_info *g, const char *path){
+    Snapshot_header header;
+    Pack_job job;
+    size_t row_words = ((size_t)g->wid + WORD_BITS - 1) / WORD_BITS;
+    
+    memset(&job, 0, sizeof(job));
+    job.g = g;
+    job.blocks_across = (int)((row_words + BLOCK_WORDS - 1) / BLOCK_WORDS);
+    job.blocks = job.blocks_across * ((g->len + BLOCK_ROWS - 1) / BLOCK_ROWS);
+    job.data = (unsigned char *)malloc((size_t)job.blocks * BLOCK_BOUND);
+    job.sizes = (size_t *)malloc((size_t)job.blocks * sizeof(size_t));
+    job.offsets = (uint64_t *)malloc(((size_t)job.blocks + 1) * sizeof(uint64_t));
+    if (job.data == NULL || job.sizes == NULL || job.offsets == NULL) {
+        printf("Out of memory!\n");
+        free(job.data);
+        free(job.sizes);
+        free(job.offsets);
+        return -1;
+    }
+    pool_run(g->pool, pack_blocks, &job);
+    job.offsets[0] = 0;
+    for(int b=0; b<job.blocks; b++){
+        job.offsets[b + 1] = job.offsets[b] + job.sizes[b];
+    }
+    
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "GOLSNAP", 8);
+    header.version = SNAPSHOT_PACKED;
+    header.header_bytes = sizeof(header);
+    header.len = g->len;
+    header.wid = g->wid;
+    header.stride = g->stride;
+    header.generation = g->generation;
+    strcpy(header.rule, life_rule.name);
+    
+    FILE *file = fopen(path, "wb");
+    int failed = (file == NULL);
+    if (file != NULL) {
+        failed |= fwrite(&header, sizeof(header), 1, file) != 1;
+        failed |= fwrite(job.offsets, sizeof(uint64_t), (size_t)job.blocks + 1, file) != (size_t)job.blocks + 1;
+        for(int b=0; b<job.blocks; b++){
+            failed |= fwrite(job.data + (size_t)b * BLOCK_BOUND, 1, job.sizes[b], file) != job.sizes[b];
+        }
+        failed |= fflush(file) != 0 || fsync(fileno(file)) != 0;
+        failed |= fclose(file) != 0;
+    }
+    free(job.data);
+    free(job.sizes);
+    free(job.offsets);
+    if (failed) {
+        printf("Could not write %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+//Loads a compressed snapshot, whose header has already been read from file. The file is mapped into memory and its blocks are unpacked into a new board on the board's thread pool if it has one. It returns -1 if the file is damaged or the memory could not be found.
+static int load_packed(Grid_info *g, int file, const Snapshot_header *header, const char *path){
+    struct stat info;
+    Pack_job job;
+    size_t row_words = ((size_t)header->wid + WORD_BITS - 1) / WORD_BITS;
+    
+    memset(&job, 0, sizeof(job));
+    job.blocks_across = (int)((row_words + BLOCK_WORDS - 1) / BLOCK_WORDS);
+    job.blocks = job.blocks_across * ((header->len + BLOCK_ROWS - 1) / BLOCK_ROWS);
+    size_t index = sizeof(Snapshot_header) + ((size_t)job.blocks + 1) * sizeof(uint64_t);
+    if (fstat(file, &info) != 0 || (size_t)info.st_size < index) {
+        printf("%s is not a snapshot this program can read\n", path);
+        return -1;
+    }
+    void *mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (mapping == MAP_FAILED) {
+        printf("Could not map %s\n", path);
+        return -1;
+    }
+    job.offsets = (uint64_t *)((char *)mapping + sizeof(Snapshot_header));
+    job.data = (unsigned char *)mapping + index;
+    job.data_bytes = (size_t)info.st_size - index;
+    int damaged = (job.offsets[0] != 0 || job.offsets[job.blocks] != job.data_bytes);
+    for(int b=0; b<job.blocks && damaged == 0; b++){
+        damaged = job.offsets[b + 1] < job.offsets[b];
+    }
+    if (damaged) {
+        printf("%s is not a snapshot this program can read\n", path);
+        munmap(mapping, (size_t)info.st_size);
+        return -1;
+    }
+    if (grid_resize(g, header->len, header->wid) != 0) {
+        printf("Out of memory!\n");
+        munmap(mapping, (size_t)info.st_size);
+        return -1;
+    }
+    job.g = g;
+    pool_run(g->pool, unpack_blocks, &job);
+    munmap(mapping, (size_t)info.st_size);
+    if (atomic_load(&job.failed)) {
+        printf("%s is damaged\n", path);
+        return -1;
+    }
+    g->generation = header->generation;
+    return 0;
+}
+
+//Writes the board to a binary snapshot (see Snapshot_header), which can be loaded again far faster than a text or RLE file. It returns -1 if the file could not be written.
+int save_snapshot(Grid_info *g, const char *path){
+    static const char padding[SNAPSHOT_HEADER];
+    Snapshot_header header;
+    FILE *file = fopen(path, "wb");
+    size_t words = (size_t)g->len * g->stride;
+    
+    if (file == NULL) {
+        printf("Could not open %s\n", path);
+        return -1;
+    }
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "GOLSNAP", 8);
+    header.version = SNAPSHOT_VERSION;
+    header.header_bytes = SNAPSHOT_HEADER;
+    header.len = g->len;
+    header.wid = g->wid;
+    header.stride = g->stride;
+    header.generation = g->generation;
+    strcpy(header.rule, life_rule.name);
+    
+    int failed = fwrite(&header, sizeof(header), 1, file) != 1;
+    failed |= fwrite(padding, SNAPSHOT_HEADER - sizeof(header), 1, file) != 1;
+    failed |= fwrite(g->grid, sizeof(uint64_t), words, file) != words;
+    failed |= fflush(file) != 0 || fsync(fileno(file)) != 0;
+    failed |= fclose(file) != 0;
+    if (failed) {
+        printf("Could not write %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+//Loads a binary snapshot. A compressed snapshot is unpacked with load_packed(), and an uncompressed one is loaded by mapping the file into memory as the board, so nothing is read or copied until the cells are used. The mapping is private, so stepping the board afterwards never changes the file. The second board is mapped as anonymous memory, which the system hands out already zeroed as it is touched. It returns -1 if the file isn't a snapshot this program can read or the memory could not be found.
+int load_snapshot(Grid_info *g, const char *path){
+    Snapshot_header header;
+    struct stat info;
+    int file = open(path, O_RDONLY);
+    
+    if (file < 0) {
+        printf("Could not open %s\n", path);
+        return -1;
+    }
+    memset(&header, 0, sizeof(header));
+    int complete = read(file, &header, sizeof(header)) == (ssize_t)sizeof(header);
+    int packed = (header.version == SNAPSHOT_PACKED && header.header_bytes == sizeof(header));
+    int mapped = (header.version == SNAPSHOT_VERSION && header.header_bytes == SNAPSHOT_HEADER && fstat(file, &info) == 0 && (size_t)info.st_size >= SNAPSHOT_HEADER + (size_t)header.len * header.stride * sizeof(uint64_t));
+    if (complete == 0 || (packed == 0 && mapped == 0) || memcmp(header.magic, "GOLSNAP", 8) != 0 || header.len < 1 || header.wid < 1 || header.len > MAX_DIMENSION || header.wid > MAX_DIMENSION || header.stride != row_stride(header.wid)) {
+        printf("%s is not a snapshot this program can read\n", path);
+        close(file);
+        return -1;
+    }
+    //The board is run with the rule it was saved with. Older snapshots always hold B3/S23 here.
+    header.rule[sizeof(header.rule) - 1] = '\0';
+    if (header.rule[0] != '\0' && set_rule(header.rule) != 0) {
+        close(file);
+        return -1;
+    }
+    if (packed) {
+        int status = load_packed(g, file, &header, path);
+        close(file);
+        return status;
+    }
+    size_t bytes = (size_t)header.len * header.stride * sizeof(uint64_t);
+    
+    //The file is mapped before the old board is given up, so the old board is left as it was if it can't be.
+    void *mapping[2];
+    mapping[0] = mmap(NULL, SNAPSHOT_HEADER + bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+    mapping[1] = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    close(file);
+    if (mapping[0] == MAP_FAILED || mapping[1] == MAP_FAILED) {
+        printf("Could not map %s\n", path);
+        if (mapping[0] != MAP_FAILED) {
+            munmap(mapping[0], SNAPSHOT_HEADER + bytes);
+        }
+        if (mapping[1] != MAP_FAILED) {
+            munmap(mapping[1], bytes);
+        }
+        return -1;
+    }
+    board_release(g);
+    g->mapping[0] = mapping[0];
+    g->mapping[1] = mapping[1];
+    g->mapping_bytes[0] = SNAPSHOT_HEADER + bytes;
+    g->mapping_bytes[1] = bytes;
+    g->grid = (uint64_t *)((char *)g->mapping[0] + SNAPSHOT_HEADER);
+    g->next_grid = (uint64_t *)g->mapping[1];
+    g->capacity = bytes / sizeof(uint64_t);
+    //Only the tile flags can fail here. The old board has gone by then, so the board is left empty rather than half set up.
+    if (grid_shape(g, header.len, header.wid) != 0) {
+        printf("Out of memory!\n");
+        board_release(g);
+        g->len = 0;
+        g->wid = 0;
+        g->tiles_down = 0;
+        g->tiles_across = 0;
+        g->active_count = 0;
+        return -1;
+    }
+    g->generation = header.generation;
+    return 0;
+}
+
+//Reads a board from a file, as RLE if the name ends in .rle, as a binary snapshot (compressed or not) if it ends in .gol or .golraw and as plain text otherwise.
+int load_board(Grid_info *g, const char *path){
+    size_t size = strlen(path);
+    if (size > 4 && strcmp(path + size - 4, ".rle") == 0) {
+        return load_rle(g, path);
+    }
+    if ((size > 4 && strcmp(path + size - 4, ".gol") == 0) || (size > 7 && strcmp(path + size - 7, ".golraw") == 0)) {
+        return load_snapshot(g, path);
+    }
+    return load_text(g, path);
+}
+
+//Writes the board to a file, as RLE if the name ends in .rle, as a compressed snapshot if it ends in .gol, as an uncompressed snapshot that can be mapped straight in if it ends in .golraw and as plain text otherwise.
+int save_board(Grid_info *g, const char *path){
+    size_t size = strlen(path);
+    if (size > 4 && strcmp(path + size - 4, ".rle") == 0) {
+        return save_rle(g, path);
+    }
+    if (size > 4 && strcmp(path + size - 4, ".gol") == 0) {
+        return save_packed(g, path);
+    }
+    if (size > 7 && strcmp(path + size - 7, ".golraw") == 0) {
+        return save_snapshot(g, path);
+    }
+    return save_text(g, path);
+}
+
+//Writes a number as a varint: seven bits to a byte, lowest first, with the top bit of each byte set if more bytes follow. Small numbers take one byte.
+static void put_varint(FILE *file, uint64_t value){
+    while (value >= 0x80) {
+        putc((int)(value & 0x7F) | 0x80, file);
+        value >>= 7;
+    }
+    putc((int)value, file);
+}
+
+//Reads a varint written by put_varint(). It returns -1 at the end of the file.
+static int get_varint(FILE *file, uint64_t *value){
+    int c, shift = 0;
+    *value = 0;
+    while ((c = getc(file)) != EOF && shift < 64) {
+        *value |= (uint64_t)(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) {
+            return 0;
+        }
+        shift += 7;
+    }
+    return -1;
+}
+
+//Starts a delta stream: "GOLDELTA" followed by varints for the version, the length and width of the board and the generation of the first frame. The first frame is the board itself (the cells that differ from an empty board), so the stream can be replayed on its own.
+void delta_start(FILE *file, Grid_info *g){
+    fwrite("GOLDELTA", 1, 8, file);
+    put_varint(file, 1);
+    put_varint(file, (uint64_t)g->len);
+    put_varint(file, (uint64_t)g->wid);
+    put_varint(file, g->generation);
+    delta_frame(file, g, NULL, g->grid, 0);
+}
+
+//Writes one frame of a delta stream: the cells that differ between the boards before and after (an empty board if before is NULL). Each changed cell is given by how many cells were skipped since the last one, counting along the rows, plus one, as a varint, and a 0 ends the frame. A generation where a few cells change takes a few bytes. If use_tiles is set, only the tiles that next() marked as changed are compared, otherwise the whole board is. The tiles are gone through a band of rows at a time so the cells come out in order.
+void delta_frame(FILE *file, Grid_info *g, const uint64_t *before, const uint64_t *after, int use_tiles){
+    size_t words = ((size_t)g->wid + WORD_BITS - 1) / WORD_BITS;
+    uint64_t previous = 0;
+    
+    for(int down=0; down<g->tiles_down; down++){
+        int first_row = down * TILE_ROWS, end_row = (first_row + TILE_ROWS < g->len) ? first_row + TILE_ROWS : g->len, any = !use_tiles;
+        const unsigned char *changed = g->next_changed + (size_t)down * g->tiles_across;
+        for(int across=0; across<g->tiles_across && any == 0; across++){
+            any = changed[across];
+        }
+        if (any == 0) {
+            continue;
+        }
+        for(int l=first_row; l<end_row; l++){
+            size_t row = (size_t)l * g->stride;
+            for(int across=0; across<g->tiles_across; across++){
+                if (use_tiles && changed[across] == 0) {
+                    continue;
+                }
+                size_t first = (size_t)across * TILE_WORDS, end = (first + TILE_WORDS < words) ? first + TILE_WORDS : words;
+                for(size_t k=first; k<end; k++){
+                    uint64_t differ = after[row + k] ^ ((before == NULL) ? 0 : before[row + k]);
+                    while (differ != 0) {
+                        uint64_t index = (uint64_t)l * (uint64_t)g->wid + k * WORD_BITS + (uint64_t)__builtin_ctzll(differ);
+                        put_varint(file, index - previous + 1);
+                        previous = index + 1;
+                        differ &= differ - 1;
+                    }
+                }
+            }
+        }
+    }
+    put_varint(file, 0);
+}
+
+//Replays a delta stream back into full boards. Usage: game replay -i stream [-o output] [-g generation]
+//If the output name has a % in it (such as frame%.rle) every frame is written out, with the % replaced by the generation, and otherwise only the board at the given generation (or the last one) is. The boards are written with save_board(), so the format follows the file name.
+int replay(int argc, char *argv[]){
+    const char *in = NULL, *out = NULL;
+    long stop = -1;
+    int option, frames = 0;
+    uint64_t version, len, wid, generation, gap;
+    char magic[8], name[4096];
+    Grid_info g;
+    
+    while ((option = getopt(argc - 1, argv + 1, "i:o:g:")) != -1) {
+        switch (option) {
+            case 'i': in = optarg; break;
+            case 'o': out = optarg; break;
+            case 'g': stop = atol(optarg); break;
+            default: in = NULL; break;
+        }
+    }
+    if (in == NULL) {
+        printf("Usage: game replay -i stream [-o output] [-g generation]\n");
+        return -1;
+    }
+    FILE *file = fopen(in, "rb");
+    if (file == NULL) {
+        printf("Could not open %s\n", in);
+        return -1;
+    }
+    //The size is checked before it is cut down to an int, so a damaged header can't pass for a smaller board.
+    if (fread(magic, 1, 8, file) != 8 || memcmp(magic, "GOLDELTA", 8) != 0 || get_varint(file, &version) != 0 || version != 1 || get_varint(file, &len) != 0 || get_varint(file, &wid) != 0 || get_varint(file, &generation) != 0 || len > MAX_DIMENSION || wid > MAX_DIMENSION || grid_alloc(&g, (int)len, (int)wid) != 0) {
+        printf("%s is not a delta stream this program can read\n", in);
+        fclose(file);
+        return -1;
+    }
+    
+    //Each frame flips the cells it lists.
+    g.generation = generation;
+    while (get_varint(file, &gap) == 0) {
+        uint64_t index = 0, cells = (uint64_t)g.len * (uint64_t)g.wid;
+        int broken = 0;
+        while (gap != 0) {
+            index += gap - 1;
+            if (index >= cells) {
+                broken = 1;
+                break;
+            }
+            g.grid[(index / (uint64_t)g.wid) * g.stride + (index % (uint64_t)g.wid) / WORD_BITS] ^= (uint64_t)1 << ((index % (uint64_t)g.wid) % WORD_BITS);
+            index += 1;
+            if (get_varint(file, &gap) != 0) {
+                broken = 1;
+                break;
+            }
+        }
+        if (broken) {
+            printf("%s ends part way through a frame or has cells outside the board\n", in);
+            break;
+        }
+        g.generation = generation + (uint64_t)frames;
+        frames += 1;
+        if (out != NULL && strchr(out, '%') != NULL) {
+            frame_name(name, sizeof(name), out, g.generation);
+            if (save_board(&g, name) != 0) {
+                break;
+            }
+        }
+        if (stop >= 0 && g.generation == (uint64_t)stop) {
+            break;
+        }
+    }
+    fclose(file);
+    
+    printf("Replayed %d frames of a %dx%d board up to generation %llu, population %llu\n", frames, g.len, g.wid, (unsigned long long)g.generation, (unsigned long long)population(&g));
+    int status = (out != NULL && strchr(out, '%') == NULL) ? save_board(&g, out) : 0;
+    grid_free(&g);
+    return status;
+}
+
+//Starts a time series of the board's statistics: "GOLSTATS" followed by varints for the version, the length and width of the board, and the generation it starts at and its population then. The record for that first generation follows.
+void stats_start(FILE *file, Grid_info *g){
+    fwrite("GOLSTATS", 1, 8, file);
+    put_varint(file, 1);
+    put_varint(file, (uint64_t)g->len);
+    put_varint(file, (uint64_t)g->wid);
+    put_varint(file, g->generation);
+    put_varint(file, g->stats->population);
+    stats_record(file, g->stats);
+}
+
+//Writes the record of a generation to a time series: varints for the births and deaths, then how far each side of the box has moved since the last record, zigzag encoded so that a small move either way takes one byte (the box before the first record is taken as all -1, like an empty board's). The population isn't written, as it follows from the births and deaths, so a record is usually only a few bytes.
+void stats_record(FILE *file, Board_stats *s){
+    put_varint(file, s->births);
+    put_varint(file, s->deaths);
+    for(int i=0; i<4; i++){
+        int64_t move = (int64_t)s->box[i] - s->written[i];
+        put_varint(file, ((uint64_t)move << 1) ^ (uint64_t)(move >> 63));
+        s->written[i] = s->box[i];
+    }
+}
+
+//Prints a time series of statistics as comma separated values, one line for each generation: the generation, population, births and deaths and the top, left, bottom and right of the live cells (-1 for an empty board). Usage: game stats -i series
+int statistics(int argc, char *argv[]){
+    const char *in = NULL;
+    int option, box[4] = {-1, -1, -1, -1};
+    uint64_t version, len, wid, generation, population, births, deaths, moves[4] = {0};
+    char magic[8];
+    
+    while ((option = getopt(argc - 1, argv + 1, "i:")) != -1) {
+        in = (option == 'i') ? optarg : NULL;
+    }
+    if (in == NULL) {
+        printf("Usage: game stats -i series\n");
+        return -1;
+    }
+    FILE *file = fopen(in, "rb");
+    if (file == NULL) {
+        printf("Could not open %s\n", in);
+        return -1;
+    }
+    if (fread(magic, 1, 8, file) != 8 || memcmp(magic, "GOLSTATS", 8) != 0 || get_varint(file, &version) != 0 || version != 1 || get_varint(file, &len) != 0 || get_varint(file, &wid) != 0 || get_varint(file, &generation) != 0 || get_varint(file, &population) != 0) {
+        printf("%s is not a time series this program can read\n", in);
+        fclose(file);
+        return -1;
+    }
+    
+    printf("generation,population,births,deaths,top,left,bottom,right\n");
+    while (get_varint(file, &births) == 0) {
+        int broken = get_varint(file, &deaths) != 0;
+        for(int i=0; i<4 && broken == 0; i++){
+            broken = get_varint(file, &moves[i]) != 0;
+            int64_t side = box[i] + ((int64_t)(moves[i] >> 1) ^ -(int64_t)(moves[i] & 1));
+            broken |= side < -1 || side >= (int64_t)((i % 2 == 0) ? len : wid);
+            box[i] = (int)side;
+        }
+        if (broken || deaths > population + births) {
+            printf("%s ends part way through a record or has a record that doesn't fit the board\n", in);
+            fclose(file);
+            return -1;
+        }
+        population += births - deaths;
+        printf("%llu,%llu,%llu,%llu,%d,%d,%d,%d\n", (unsigned long long)generation, (unsigned long long)population, (unsigned long long)births, (unsigned long long)deaths, box[0], box[1], box[2], box[3]);
+        generation += 1;
+    }
+    fclose(file);
+    return 0;
+}
+
+//Makes the name of the file for a frame from a pattern, with the % in the pattern replaced by the generation.
+void frame_name(char *name, size_t size, const char *pattern, uint64_t generation){
+    const char *mark = strchr(pattern, '%');
+    if (mark == NULL) {
+        snprintf(name, size, "%s", pattern);
+        return;
+    }
+    snprintf(name, size, "%.*s%llu%s", (int)(mark - pattern), pattern, (unsigned long long)generation, mark + 1);
+}
+
+//Encodes row l of a board as one row of pixels. A PBM row packs eight pixels to a byte with the first pixel in the top bit, and 1 is black, so live cells are black. A grey row has one byte a pixel, 255 for live cells.
+static void export_row(const Exporter *e, const uint64_t *board, int l, unsigned char *out){
+    const uint64_t *row = board + (size_t)l * e->stride;
+    size_t pixels = (size_t)e->wid * e->zoom;
+    
+    if (e->format == EXPORT_PBM) {
+        memset(out, 0, (pixels + 7) / 8);
+        if (e->zoom == 1) {
+            //The board keeps the first cell of each word in the lowest bit, so each byte only needs its bits reversing.
+            for(size_t i=0; i<((size_t)e->wid + 7) / 8; i++){
+                unsigned char b = (unsigned char)(row[i / 8] >> (8 * (i % 8)));
+                b = (unsigned char)(((b * 0x0802u & 0x22110u) | (b * 0x8020u & 0x88440u)) * 0x10101u >> 16);
+                out[i] = b;
+            }
+            return;
+        }
+        for(int w=0; w<e->wid; w++){
+            if ((row[w / WORD_BITS] >> (w % WORD_BITS)) & 1) {
+                for(size_t p=(size_t)w * e->zoom; p<(size_t)(w + 1) * e->zoom; p++){
+                    out[p / 8] |= (unsigned char)(0x80 >> (p % 8));
+                }
+            }
+        }
+        return;
+    }
+    if (e->zoom == 1) {
+        for(int w=0; w<e->wid; w+=8){
+            unsigned char b = (unsigned char)(row[w / WORD_BITS] >> (w % WORD_BITS));
+            memcpy(out + w, e->spread[b], (e->wid - w < 8) ? (size_t)(e->wid - w) : 8);
+        }
+        return;
+    }
+    for(int w=0; w<e->wid; w++){
+        memset(out + (size_t)w * e->zoom, ((row[w / WORD_BITS] >> (w % WORD_BITS)) & 1) ? 255 : 0, (size_t)e->zoom);
+    }
+}
+
+//Encodes a frame. A raw frame goes into the job's image, and a PBM or PGM frame is written to its own file a row at a time. It returns -1 if the file could not be written.
+static int export_encode(Exporter *e, Export_job *job, unsigned char *row){
+    size_t width = (size_t)e->wid * e->zoom, row_bytes = (e->format == EXPORT_PBM) ? (width + 7) / 8 : width;
+    char name[4096];
+    
+    if (e->format == EXPORT_RAW) {
+        for(int l=0; l<e->len; l++){
+            export_row(e, job->board, l, row);
+            for(int z=0; z<e->zoom; z++){
+                memcpy(job->image + ((size_t)l * e->zoom + z) * row_bytes, row, row_bytes);
+            }
+        }
+        return 0;
+    }
+    frame_name(name, sizeof(name), e->pattern, job->generation);
+    FILE *file = fopen(name, "wb");
+    if (file == NULL) {
+        return -1;
+    }
+    fprintf(file, (e->format == EXPORT_PBM) ? "P4\n%zu %zu\n" : "P5\n%zu %zu\n255\n", width, (size_t)e->len * e->zoom);
+    for(int l=0; l<e->len; l++){
+        export_row(e, job->board, l, row);
+        for(int z=0; z<e->zoom; z++){
+            fwrite(row, 1, row_bytes, file);
+        }
+    }
+    return (fclose(file) != 0) ? -1 : 0;
+}
+
+//Writes out the raw frames that are ready, in order. It is called with the lock held, and lets go of it while writing.
+static void export_flush(Exporter *e){
+    size_t bytes = (size_t)e->wid * e->zoom * e->len * e->zoom;
+    while (e->writing == 0) {
+        Export_job *job = NULL;
+        for(int i=0; i<e->slots; i++){
+            if (e->jobs[i].state == 3 && e->jobs[i].sequence == e->next_write) {
+                job = &e->jobs[i];
+            }
+        }
+        if (job == NULL) {
+            return;
+        }
+        e->writing = 1;
+        pthread_mutex_unlock(&e->lock);
+        int failed = fwrite(job->image, 1, bytes, e->stream) != bytes;
+        pthread_mutex_lock(&e->lock);
+        e->failed |= failed;
+        e->writing = 0;
+        e->next_write += 1;
+        e->frames += 1;
+        job->state = 0;
+        pthread_cond_broadcast(&e->space);
+    }
+}
+
+//An export worker. It encodes the oldest frame waiting, and for a raw stream writes out any frames that are ready in order, until it is told to quit and nothing is left waiting.
+static void *export_worker(void *arg){
+    Exporter *e = (Exporter *)arg;
+    unsigned char *row = (unsigned char *)malloc((size_t)e->wid * e->zoom);
+    
+    pthread_mutex_lock(&e->lock);
+    while (1) {
+        Export_job *job = NULL;
+        for(int i=0; i<e->slots; i++){
+            if (e->jobs[i].state == 1 && (job == NULL || e->jobs[i].sequence < job->sequence)) {
+                job = &e->jobs[i];
+            }
+        }
+        if (job == NULL) {
+            if (e->quit) {
+                break;
+            }
+            pthread_cond_wait(&e->work, &e->lock);
+            continue;
+        }
+        job->state = 2;
+        pthread_mutex_unlock(&e->lock);
+        int failed = (row == NULL) || export_encode(e, job, row) != 0;
+        pthread_mutex_lock(&e->lock);
+        e->failed |= failed;
+        if (e->format == EXPORT_RAW) {
+            job->state = 3;
+            export_flush(e);
+        }
+        else{
+            job->state = 0;
+            e->frames += 1;
+            pthread_cond_broadcast(&e->space);
+        }
+    }
+    pthread_mutex_unlock(&e->lock);
+    free(row);
+    return NULL;
+}
+
+//The number of threads to encode exported frames with while stepping threads step the board: the processors the stepping threads leave free, and at least one, so the encoders don't crowd out the stepping threads.
+int export_threads(int stepping){
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return (processors > stepping) ? (int)(processors - stepping) : 1;
+}
+
+//Starts exporting frames of a board of len by wid cells. The format is taken from the name: a name ending in .pbm or .pgm gives one file per frame (with % in the name replaced by the generation), and anything else is a raw stream of grey frames, with - meaning standard output. threads workers are started, with one more slot than workers so the stepping thread can always be filling one. It returns -1 if the output could not be opened or the memory or threads could not be found.
+int export_start(Exporter *e, Grid_info *g, const char *pattern, int zoom, int threads){
+    size_t size = strlen(pattern), words = (size_t)g->len * g->stride;
+    
+    memset(e, 0, sizeof(Exporter));
+    e->pattern = pattern;
+    e->zoom = (zoom < 1) ? 1 : zoom;
+    e->len = g->len;
+    e->wid = g->wid;
+    e->stride = g->stride;
+    for(int b=0; b<256; b++){
+        for(int i=0; i<8; i++){
+            e->spread[b][i] = ((b >> i) & 1) ? 255 : 0;
+        }
+    }
+    e->format = (size > 4 && strcmp(pattern + size - 4, ".pbm") == 0) ? EXPORT_PBM : (size > 4 && strcmp(pattern + size - 4, ".pgm") == 0) ? EXPORT_PGM : EXPORT_RAW;
+    e->slots = threads + 1;
+    e->jobs = (Export_job *)calloc((size_t)e->slots, sizeof(Export_job));
+    e->threads = (pthread_t *)malloc((size_t)threads * sizeof(pthread_t));
+    if (e->jobs == NULL || e->threads == NULL) {
+        export_finish(e);
+        return -1;
+    }
+    for(int i=0; i<e->slots; i++){
+        e->jobs[i].board = (uint64_t *)malloc(words * sizeof(uint64_t));
+        if (e->format == EXPORT_RAW) {
+            e->jobs[i].image = (unsigned char *)malloc((size_t)e->wid * e->zoom * e->len * e->zoom);
+        }
+        if (e->jobs[i].board == NULL || (e->format == EXPORT_RAW && e->jobs[i].image == NULL)) {
+            export_finish(e);
+            return -1;
+        }
+    }
+    int to_stdout = e->format == EXPORT_RAW && strcmp(pattern, "-") == 0;
+    if (to_stdout) {
+        fflush(stdout);
+        int fd = dup(STDOUT_FILENO);
+        e->stream = (fd < 0) ? NULL : fdopen(fd, "wb");
+        if (fd >= 0 && e->stream == NULL) {
+            close(fd);
+        }
+    }
+    else if (e->format == EXPORT_RAW) {
+        e->stream = fopen(pattern, "wb");
+    }
+    if (e->format == EXPORT_RAW && e->stream == NULL) {
+        printf("Could not open %s\n", pattern);
+        export_finish(e);
+        return -1;
+    }
+    pthread_mutex_init(&e->lock, NULL);
+    pthread_cond_init(&e->work, NULL);
+    pthread_cond_init(&e->space, NULL);
+    for(int i=0; i<threads; i++){
+        if (pthread_create(&e->threads[i], NULL, export_worker, e) != 0) {
+            break;
+        }
+        e->thread_count += 1;
+    }
+    if (e->thread_count == 0) {
+        export_finish(e);
+        return -1;
+    }
+    //The frames get standard output to themselves, and anything else printed from here on goes to standard error so it can't end up in the middle of a frame. This is left until nothing else can fail, so standard output is never taken over by an export that didn't start.
+    if (to_stdout && dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        export_finish(e);
+        return -1;
+    }
+    return 0;
+}
+
+//Hands the board to the export workers as the next frame. It copies the board and returns straight away unless every slot is still in use, in which case it waits for one to come free.
+void export_frame(Exporter *e, Grid_info *g){
+    Export_job *job = NULL;
+    
+    pthread_mutex_lock(&e->lock);
+    while (job == NULL) {
+        for(int i=0; i<e->slots && job == NULL; i++){
+            if (e->jobs[i].state == 0) {
+                job = &e->jobs[i];
+            }
+        }
+        if (job == NULL) {
+            pthread_cond_wait(&e->space, &e->lock);
+        }
+    }
+    pthread_mutex_unlock(&e->lock);
+    //The slot is free, so nothing else touches it until it is handed over below.
+    memcpy(job->board, g->grid, (size_t)e->len * e->stride * sizeof(uint64_t));
+    pthread_mutex_lock(&e->lock);
+    job->generation = g->generation;
+    job->sequence = e->next_sequence++;
+    job->state = 1;
+    pthread_cond_signal(&e->work);
+    pthread_mutex_unlock(&e->lock);
+}
+
+//Waits for every frame to be written, stops the workers and frees everything. It returns -1 if any frame could not be written.
+int export_finish(Exporter *e){
+    if (e->thread_count > 0) {
+        pthread_mutex_lock(&e->lock);
+        e->quit = 1;
+        pthread_cond_broadcast(&e->work);
+        pthread_mutex_unlock(&e->lock);
+        for(int i=0; i<e->thread_count; i++){
+            pthread_join(e->threads[i], NULL);
+        }
+        pthread_mutex_destroy(&e->lock);
+        pthread_cond_destroy(&e->work);
+        pthread_cond_destroy(&e->space);
+    }
+    for(int i=0; i<e->slots && e->jobs != NULL; i++){
+        free(e->jobs[i].board);
+        free(e->jobs[i].image);
+    }
+    free(e->jobs);
+    free(e->threads);
+    if (e->stream != NULL) {
+        e->failed |= fclose(e->stream) != 0;
+    }
+    e->jobs = NULL;
+    e->threads = NULL;
+    e->thread_count = 0;
+    return e->failed ? -1 : 0;
+}
+
+// This function lets the user choose 1 of 5 preconfigured grids to be but into the structure and therefore be run in the game. The grids are displayed to the user so they can choose. The two small grids are kept as arrays, but the three larger grids are read from plain text files straight into the board from the directory the program is run in, so their size is whatever the file holds. It returns -1 if a grid could not be loaded.
+int preset(Grid_info *g){
+    int grid1[10][10], grid2[10][10] = {{0,0,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,1,0,0}, {0,0,0,0,0,1,0,1,0,0}, {0,0,0,0,0,0,1,1,0,0}, {0,0,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0,0,0}};
+    const char *files[3] = {"grid3.txt", "grid4.txt", "grid5.txt"};
+    const char *names[3] = {"Grid 3 - Pattern", "Grid 4 - Oscillator", "Grid 5 - Gun"};
+    
+    //Grid 1 has cells that are randomised alive or dead (0 or 1).
+    for(int l=0; l<10; l++){
+        for(int w=0; w<10; w++){
+            grid1[l][w] = rand() % 2;
+        }
+    }
+
+    //Shows the grids to the user so they can choose one.
+    printf("Please choose one of the five following starting grids to run.\n");
+    printf("\nGrid 1 - Picked randomly (10x10):\n");
+    if (grid_resize(g, 10, 10) != 0) {
+        printf("Out of memory!\n");
+        return -1;
+    }
+    equal_grids(g, grid1);
+    print_board(g);
+    sleep(2);
+    
+    printf("Grid 2 - Glider (10x10):\n");
+    equal_grids(g, grid2);
+    print_board(g);
+    sleep(2);
+    
+    for(int i=0; i<3; i++){
+        if (load_board(g, files[i]) != 0) {
+            return -1;
+        }
+        printf("%s (%dx%d):\n", names[i], g->len, g->wid);
+        print_board(g);
+        if (i < 2) {
+            sleep(2);
+        }
+    }
+    
+    printf("Please enter 1 for grid 1, 2 for grid 2 etc... :\n");
+    int x = input(1,5);
+    
+    //After the user chooses a grid, the correct numbers from an array or file are entered into the structure.
+    if(x == 1 || x == 2){
+        if (grid_resize(g, 10, 10) != 0) {
+            printf("Out of memory!\n");
+            return -1;
+        }
+        equal_grids(g, (x == 1) ? grid1 : grid2);
+    }
+    else{
+        return load_board(g, files[x-3]);
+    }
+    return 0;
+}
+
+//The hash of a node is worked out from the addresses of its four quarters, as two nodes with the same quarters are the same square.
+static size_t hl_hash(Node *nw, Node *ne, Node *sw, Node *se){
+    uint64_t h = (uint64_t)(uintptr_t)nw * 0x9E3779B97F4A7C15u;
+    h = (h ^ (uint64_t)(uintptr_t)ne) * 0xC2B2AE3D27D4EB4Fu;
+    h = (h ^ (uint64_t)(uintptr_t)sw) * 0x165667B19E3779F9u;
+    h = (h ^ (uint64_t)(uintptr_t)se) * 0x9E3779B97F4A7C15u;
+    return (size_t)(h ^ (h >> 31));
+}
+
+//Sets up an empty HashLife universe that starts collecting garbage once it holds node_limit nodes. It returns -1 if the memory could not be found.
+int hl_init(Hashlife *hl, size_t node_limit){
+    memset(hl, 0, sizeof(Hashlife));
+    hl->node_limit = (node_limit < 1024) ? 1024 : node_limit;
+    hl->gc_at = hl->node_limit;
+    hl->bucket_count = 1 << 16;
+    hl->buckets = (Node **)calloc(hl->bucket_count, sizeof(Node *));
+    if (hl->buckets == NULL) {
+        return -1;
+    }
+    hl->leaf[1].population = 1;
+    hl->step = -1;
+    hl->root = hl_empty(hl, 3);
+    return 0;
+}
+
+//Frees every node and the hash table.
+void hl_free(Hashlife *hl){
+    for(int i=0; i<hl->block_count; i++){
+        free(hl->blocks[i]);
+    }
+    free(hl->blocks);
+    free(hl->buckets);
+    hl->blocks = NULL;
+    hl->buckets = NULL;
+}
+
+//Doubles the number of hash buckets and moves every node into its new bucket.
+static void hl_rehash(Hashlife *hl){
+    size_t count = hl->bucket_count * 2;
+    Node **buckets = (Node **)calloc(count, sizeof(Node *));
+    if (buckets == NULL) {
+        return;
+    }
+    for(size_t b=0; b<hl->bucket_count; b++){
+        Node *n = hl->buckets[b];
+        while (n != NULL) {
+            Node *chain = n->chain;
+            size_t h = hl_hash(n->nw, n->ne, n->sw, n->se) & (count - 1);
+            n->chain = buckets[h];
+            buckets[h] = n;
+            n = chain;
+        }
+    }
+    free(hl->buckets);
+    hl->buckets = buckets;
+    hl->bucket_count = count;
+}
+
+//Returns the one node made of these four quarters, making it if it doesn't exist yet. This never collects garbage, so the quarters passed in are safe however they were made.
+Node *hl_join(Hashlife *hl, Node *nw, Node *ne, Node *sw, Node *se){
+    size_t h = hl_hash(nw, ne, sw, se) & (hl->bucket_count - 1);
+    Node *n;
+    
+    for(n = hl->buckets[h]; n != NULL; n = n->chain){
+        if (n->nw == nw && n->ne == ne && n->sw == sw && n->se == se) {
+            return n;
+        }
+    }
+    if (hl->free_nodes == NULL) {
+        Node *block = (Node *)malloc(HL_BLOCK_NODES * sizeof(Node));
+        Node **blocks = (Node **)realloc(hl->blocks, (size_t)(hl->block_count + 1) * sizeof(Node *));
+        if (block == NULL || blocks == NULL) {
+            printf("Out of memory!\n");
+            exit(-1);
+        }
+        hl->blocks = blocks;
+        hl->blocks[hl->block_count++] = block;
+        for(int i=0; i<HL_BLOCK_NODES; i++){
+            block[i].chain = hl->free_nodes;
+            hl->free_nodes = &block[i];
+        }
+    }
+    n = hl->free_nodes;
+    hl->free_nodes = n->chain;
+    n->nw = nw;
+    n->ne = ne;
+    n->sw = sw;
+    n->se = se;
+    n->result = NULL;
+    n->level = nw->level + 1;
+    n->population = nw->population + ne->population + sw->population + se->population;
+    n->marked = 0;
+    n->chain = hl->buckets[h];
+    hl->buckets[h] = n;
+    hl->nodes += 1;
+    if (hl->nodes > hl->bucket_count) {
+        hl_rehash(hl);
+    }
+    return n;
+}
+
+//Returns the empty square of the given level.
+Node *hl_empty(Hashlife *hl, int level){
+    if (level == 0) {
+        return &hl->leaf[0];
+    }
+    if (hl->empty[level] == NULL) {
+        Node *e = hl_empty(hl, level - 1);
+        hl->empty[level] = hl_join(hl, e, e, e, e);
+    }
+    return hl->empty[level];
+}
+
+//Marks a node, its quarters and (unless they are being dropped) its remembered result as still in use.
+static void hl_mark(Node *n){
+    while (n != NULL && n->level > 0 && n->marked == 0) {
+        n->marked = 1;
+        hl_mark(n->nw);
+        hl_mark(n->ne);
+        hl_mark(n->sw);
+        hl_mark(n->se);
+        n = n->result;
+    }
+}
+
+//The garbage collector. Everything that can be reached from the root, the empty squares, and the nodes that calls of hl_successor() are part way through is kept, and every other node goes back on the free list. If drop_results is set, the remembered results are forgotten first so only the pattern itself is kept.
+void hl_gc(Hashlife *hl, int drop_results){
+    for(size_t b=0; b<hl->bucket_count; b++){
+        for(Node *n = hl->buckets[b]; n != NULL; n = n->chain){
+            n->marked = 0;
+            if (drop_results) {
+                n->result = NULL;
+            }
+        }
+    }
+    hl_mark(hl->root);
+    for(int i=0; i<hl->depth; i++){
+        hl_mark(hl->stack[i]);
+    }
+    for(int l=1; l<=HL_MAX_LEVEL; l++){
+        hl_mark(hl->empty[l]);
+    }
+    for(size_t b=0; b<hl->bucket_count; b++){
+        Node **link = &hl->buckets[b];
+        while (*link != NULL) {
+            Node *n = *link;
+            if (n->marked) {
+                link = &n->chain;
+            }
+            else{
+                *link = n->chain;
+                n->chain = hl->free_nodes;
+                hl->free_nodes = n;
+                hl->nodes -= 1;
+            }
+        }
+    }
+}
+
+//Works out the centre 2x2 of a 4x4 node one generation on, cell by cell with the same rule as the rest of the program.
+static Node *hl_life_4x4(Hashlife *hl, Node *n){
+    int cells[4][4], next[2][2];
+    Node *quarters[2][2] = {{n->nw, n->ne}, {n->sw, n->se}};
+    
+    for(int l=0; l<4; l++){
+        for(int w=0; w<4; w++){
+            Node *q = quarters[l/2][w/2];
+            Node *c = (l % 2 == 0) ? ((w % 2 == 0) ? q->nw : q->ne) : ((w % 2 == 0) ? q->sw : q->se);
+            cells[l][w] = (int)c->population;
+        }
+    }
+    for(int l=1; l<=2; l++){
+        for(int w=1; w<=2; w++){
+            int alive_neighbours = cells[l-1][w-1] + cells[l-1][w] + cells[l-1][w+1] + cells[l][w-1] + cells[l][w+1] + cells[l+1][w-1] + cells[l+1][w] + cells[l+1][w+1];
+            next[l-1][w-1] = alive_or_dead(cells[l][w], alive_neighbours);
+        }
+    }
+    return hl_join(hl, &hl->leaf[next[0][0]], &hl->leaf[next[0][1]], &hl->leaf[next[1][0]], &hl->leaf[next[1][1]]);
+}
+
+//Puts a node on the stack of nodes in use, so the garbage collector keeps it.
+static void hl_push(Hashlife *hl, Node *n){
+    hl->stack[hl->depth++] = n;
+}
+
+//Returns the centre of a node (one level down) 2^step generations on, or 2^(level-2) generations on if the node is too small for the full step. This is the heart of HashLife: the node is split into nine overlapping squares one level down, each of those is moved on half the time by calling this function again, and the nine results are put together into four squares that are moved on for the other half. When the step is smaller than the node allows, the second half is skipped and the centres are taken instead. Because identical nodes are shared and their results remembered, repeated parts of the pattern (in space or in time) are only ever worked out once.
+Node *hl_successor(Hashlife *hl, Node *n){
+    Node *c[9], *s[4], *r;
+    int depth = hl->depth;
+    
+    if (n->result != NULL) {
+        return n->result;
+    }
+    if (n->population == 0) {
+        return hl_empty(hl, n->level - 1);
+    }
+    //Garbage is only collected here, after n is on the stack and before anything new is made, so no node this function is holding can be lost.
+    hl_push(hl, n);
+    if (hl->nodes >= hl->gc_at) {
+        hl_gc(hl, 0);
+        if (hl->nodes > hl->node_limit / 2) {
+            hl_gc(hl, 1);
+        }
+        hl->gc_at = (hl->nodes * 2 > hl->node_limit) ? hl->nodes * 2 : hl->node_limit;
+    }
+    
+    if (n->level == 2) {
+        r = hl_life_4x4(hl, n);
+    }
+    else{
+        //Each of the nine squares is made just before it is moved on, and its result is put on the stack straight away.
+        Node *nw = n->nw, *ne = n->ne, *sw = n->sw, *se = n->se;
+        c[0] = hl_successor(hl, nw); hl_push(hl, c[0]);
+        c[1] = hl_successor(hl, hl_join(hl, nw->ne, ne->nw, nw->se, ne->sw)); hl_push(hl, c[1]);
+        c[2] = hl_successor(hl, ne); hl_push(hl, c[2]);
+        c[3] = hl_successor(hl, hl_join(hl, nw->sw, nw->se, sw->nw, sw->ne)); hl_push(hl, c[3]);
+        c[4] = hl_successor(hl, hl_join(hl, nw->se, ne->sw, sw->ne, se->nw)); hl_push(hl, c[4]);
+        c[5] = hl_successor(hl, hl_join(hl, ne->sw, ne->se, se->nw, se->ne)); hl_push(hl, c[5]);
+        c[6] = hl_successor(hl, sw); hl_push(hl, c[6]);
+        c[7] = hl_successor(hl, hl_join(hl, sw->ne, se->nw, sw->se, se->sw)); hl_push(hl, c[7]);
+        c[8] = hl_successor(hl, se); hl_push(hl, c[8]);
+        
+        if (hl->step < n->level - 2) {
+            Node *a = hl_join(hl, c[0]->se, c[1]->sw, c[3]->ne, c[4]->nw);
+            Node *b = hl_join(hl, c[1]->se, c[2]->sw, c[4]->ne, c[5]->nw);
+            Node *d = hl_join(hl, c[3]->se, c[4]->sw, c[6]->ne, c[7]->nw);
+            Node *e = hl_join(hl, c[4]->se, c[5]->sw, c[7]->ne, c[8]->nw);
+            r = hl_join(hl, a, b, d, e);
+        }
+        else{
+            s[0] = hl_successor(hl, hl_join(hl, c[0], c[1], c[3], c[4])); hl_push(hl, s[0]);
+            s[1] = hl_successor(hl, hl_join(hl, c[1], c[2], c[4], c[5])); hl_push(hl, s[1]);
+            s[2] = hl_successor(hl, hl_join(hl, c[3], c[4], c[6], c[7])); hl_push(hl, s[2]);
+            s[3] = hl_successor(hl, hl_join(hl, c[4], c[5], c[7], c[8])); hl_push(hl, s[3]);
+            r = hl_join(hl, s[0], s[1], s[2], s[3]);
+        }
+    }
+    n->result = r;
+    hl->depth = depth;
+    return r;
+}
+
+//Builds the node of the given level whose top left cell is at (top, left) on the board. Squares that are off the board, or that fit in a single word and have no live cells, are the shared empty node.
+static Node *hl_build(Hashlife *hl, Grid_info *g, int level, int64_t top, int64_t left){
+    int64_t size = (int64_t)1 << level;
+    
+    if (top >= g->len || left >= g->wid) {
+        return hl_empty(hl, level);
+    }
+    if (level == 0) {
+        return &hl->leaf[cell(g, (int)top, (int)left)];
+    }
+    if (size <= WORD_BITS) {
+        uint64_t mask = (size == WORD_BITS) ? ~(uint64_t)0 : (((uint64_t)1 << size) - 1) << (left % WORD_BITS), bits = 0;
+        for(int64_t l=top; l<top+size && l<g->len; l++){
+            bits |= g->grid[(size_t)l * g->stride + (size_t)(left / WORD_BITS)] & mask;
+        }
+        if (bits == 0) {
+            return hl_empty(hl, level);
+        }
+    }
+    Node *nw = hl_build(hl, g, level - 1, top, left);
+    Node *ne = hl_build(hl, g, level - 1, top, left + size / 2);
+    Node *sw = hl_build(hl, g, level - 1, top + size / 2, left);
+    Node *se = hl_build(hl, g, level - 1, top + size / 2, left + size / 2);
+    return hl_join(hl, nw, ne, sw, se);
+}
+
+//Loads the board into the HashLife universe, with the top left of the board at (0, 0).
+void hl_load(Hashlife *hl, Grid_info *g){
+    int level = 3;
+    while (((int64_t)1 << level) < g->len || ((int64_t)1 << level) < g->wid) {
+        level += 1;
+    }
+    hl->root = hl_build(hl, g, level, 0, 0);
+    hl->origin_l = 0;
+    hl->origin_w = 0;
+    hl->generation = 0;
+}
+
+//Draws the live cells of a node that land on the board.
+static void hl_paint(Grid_info *g, Node *n, int64_t top, int64_t left){
+    int64_t size = (int64_t)1 << n->level;
+    if (n->population == 0 || top >= g->len || left >= g->wid || top + size <= 0 || left + size <= 0) {
+        return;
+    }
+    if (n->level == 0) {
+        set_cell(g->grid, g->stride, (int)top, (int)left, 1);
+        return;
+    }
+    hl_paint(g, n->nw, top, left);
+    hl_paint(g, n->ne, top, left + size / 2);
+    hl_paint(g, n->sw, top + size / 2, left);
+    hl_paint(g, n->se, top + size / 2, left + size / 2);
+}
+
+//Copies the part of the HashLife pattern that falls on the board back into grid. Anything that has travelled off the board is left out, as HashLife doesn't wrap round.
+void hl_store(Hashlife *hl, Grid_info *g){
+    memset(g->grid, 0, (size_t)g->len * g->stride * sizeof(uint64_t));
+    hl_paint(g, hl->root, hl->origin_l, hl->origin_w);
+    g->tiles_known = 0;
+}
+
+//Puts an empty border round the root, doubling its size and keeping the pattern in the middle.
+static void hl_expand(Hashlife *hl){
+    Node *r = hl->root, *e = hl_empty(hl, r->level - 1);
+    hl->root = hl_join(hl, hl_join(hl, e, e, e, r->nw), hl_join(hl, e, e, r->ne, e), hl_join(hl, e, r->sw, e, e), hl_join(hl, r->se, e, e, e));
+    hl->origin_l -= (int64_t)1 << (r->level - 1);
+    hl->origin_w -= (int64_t)1 << (r->level - 1);
+}
+
+//Moves the pattern on by 2^k generations in one go. The results remembered in the nodes are for one step size, so they are all forgotten when k changes. The root is made big enough for a step of 2^k with the pattern inside its middle half, then given one more border, so nothing the pattern grows into in that time (at most 2^k cells each way) can fall outside the centre that hl_successor() returns. It returns -1 if the pattern has grown too big to step that far.
+int hl_advance(Hashlife *hl, int k){
+    if (k != hl->step) {
+        for(size_t b=0; b<hl->bucket_count; b++){
+            for(Node *n = hl->buckets[b]; n != NULL; n = n->chain){
+                n->result = NULL;
+            }
+        }
+        hl->step = k;
+    }
+    while (hl->root->level < k + 2 || hl->root->nw->se->population + hl->root->ne->sw->population + hl->root->sw->ne->population + hl->root->se->nw->population != hl->root->population) {
+        if (hl->root->level >= HL_MAX_LEVEL - 1) {
+            return -1;
+        }
+        hl_expand(hl);
+    }
+    if (hl->root->level >= HL_MAX_LEVEL - 1) {
+        return -1;
+    }
+    hl_expand(hl);
+    hl->depth = 0;
+    Node *r = hl_successor(hl, hl->root);
+    hl->origin_l += (int64_t)1 << (hl->root->level - 2);
+    hl->origin_w += (int64_t)1 << (hl->root->level - 2);
+    hl->root = r;
+    hl->generation += (uint64_t)1 << k;
+    return 0;
+}
+
+//The hash bucket for the chunk at (cl, cw).
+static size_t sparse_hash(const Sparse *s, int64_t cl, int64_t cw){
+    uint64_t h = ((uint64_t)cl * 0x9E3779B97F4A7C15u) ^ ((uint64_t)cw * 0xC2B2AE3D27D4EB4Fu);
+    return (size_t)(h ^ (h >> 29)) & (s->bucket_count - 1);
+}
+
+//Sets up an empty plane. It returns -1 if the memory could not be found.
+int sparse_init(Sparse *s){
+    memset(s, 0, sizeof(Sparse));
+    s->bucket_count = 1024;
+    s->buckets = (Chunk **)calloc(s->bucket_count, sizeof(Chunk *));
+    return (s->buckets == NULL) ? -1 : 0;
+}
+
+//Frees every chunk and the plane's tables.
+void sparse_free(Sparse *s){
+    for(size_t i=0; i<s->count; i++){
+        free(s->chunks[i]);
+    }
+    free(s->chunks);
+    free(s->buckets);
+    memset(s, 0, sizeof(Sparse));
+}
+
+//Returns the chunk at (cl, cw). If there isn't one it is made (empty) when make is set, and otherwise NULL is returned.
+Chunk *sparse_chunk(Sparse *s, int64_t cl, int64_t cw, int make){
+    Chunk *c;
+    
+    for(c = s->buckets[sparse_hash(s, cl, cw)]; c != NULL; c = c->chain){
+        if (c->cl == cl && c->cw == cw) {
+            return c;
+        }
+    }
+    if (make == 0) {
+        return NULL;
+    }
+    if (s->count == s->capacity) {
+        size_t capacity = (s->capacity == 0) ? 64 : s->capacity * 2;
+        Chunk **chunks = (Chunk **)realloc(s->chunks, capacity * sizeof(Chunk *));
+        if (chunks == NULL) {
+            printf("Out of memory!\n");
+            exit(-1);
+        }
+        s->chunks = chunks;
+        s->capacity = capacity;
+    }
+    //The hash table is doubled when it has as many chunks as buckets.
+    if (s->count >= s->bucket_count) {
+        Chunk **old = s->buckets;
+        size_t old_count = s->bucket_count;
+        s->bucket_count *= 2;
+        s->buckets = (Chunk **)calloc(s->bucket_count, sizeof(Chunk *));
+        if (s->buckets == NULL) {
+            printf("Out of memory!\n");
+            exit(-1);
+        }
+        for(size_t b=0; b<old_count; b++){
+            while (old[b] != NULL) {
+                Chunk *moving = old[b];
+                size_t h = sparse_hash(s, moving->cl, moving->cw);
+                old[b] = moving->chain;
+                moving->chain = s->buckets[h];
+                s->buckets[h] = moving;
+            }
+        }
+        free(old);
+    }
+    c = (Chunk *)calloc(1, sizeof(Chunk));
+    if (c == NULL) {
+        printf("Out of memory!\n");
+        exit(-1);
+    }
+    size_t h = sparse_hash(s, cl, cw);
+    c->cl = cl;
+    c->cw = cw;
+    c->chain = s->buckets[h];
+    s->buckets[h] = c;
+    c->index = s->count;
+    s->chunks[s->count++] = c;
+    return c;
+}
+
+//Takes a chunk out of the hash table and the list (moving the last chunk into its place) and frees it.
+static void sparse_remove(Sparse *s, Chunk *c){
+    Chunk **link = &s->buckets[sparse_hash(s, c->cl, c->cw)];
+    while (*link != c) {
+        link = &(*link)->chain;
+    }
+    *link = c->chain;
+    s->chunks[c->index] = s->chunks[--s->count];
+    s->chunks[c->index]->index = c->index;
+    free(c);
+}
+
+//Sets the cell at (l, w) of the plane to value, making its chunk if it needs one.
+void sparse_set(Sparse *s, int64_t l, int64_t w, int value){
+    Chunk *c = sparse_chunk(s, l >> 6, w >> 6, value);
+    uint64_t bit = (uint64_t)1 << (w & 63);
+    if (c != NULL) {
+        if (value) {
+            c->rows[s->current][l & 63] |= bit;
+        }
+        else{
+            c->rows[s->current][l & 63] &= ~bit;
+        }
+    }
+}
+
+//Works out the next generation of one chunk. The rows of the chunk, with one row from the chunks above and below, are gathered along with the matching words from the chunks either side (which the left and right neighbours of the end cells are carried in from), and then each row is worked out with the same logic as the board.
+static void sparse_step_chunk(Sparse *s, Chunk *c){
+    static const uint64_t nothing[CHUNK_SIZE];
+    const uint64_t *from[8];
+    const uint64_t *mid = c->rows[s->current];
+    uint64_t *out = c->rows[!s->current];
+    uint64_t left[CHUNK_SIZE + 2], centre[CHUNK_SIZE + 2], right[CHUNK_SIZE + 2], alive = 0, changed = 0;
+    
+    for(int i=0; i<8; i++){
+        from[i] = (c->around[i] == NULL) ? nothing : c->around[i]->rows[s->current];
+    }
+    left[0] = from[0][CHUNK_SIZE-1];
+    centre[0] = from[1][CHUNK_SIZE-1];
+    right[0] = from[2][CHUNK_SIZE-1];
+    for(int l=0; l<CHUNK_SIZE; l++){
+        left[l+1] = from[3][l];
+        centre[l+1] = mid[l];
+        right[l+1] = from[4][l];
+    }
+    left[CHUNK_SIZE+1] = from[5][0];
+    centre[CHUNK_SIZE+1] = from[6][0];
+    right[CHUNK_SIZE+1] = from[7][0];
+    
+    for(int l=0; l<CHUNK_SIZE; l++){
+        uint64_t ul = (centre[l] << 1) | (left[l] >> 63), ur = (centre[l] >> 1) | (right[l] << 63);
+        uint64_t ml = (centre[l+1] << 1) | (left[l+1] >> 63), mr = (centre[l+1] >> 1) | (right[l+1] << 63);
+        uint64_t dl = (centre[l+2] << 1) | (left[l+2] >> 63), dr = (centre[l+2] >> 1) | (right[l+2] << 63);
+        uint64_t result = rule_word(ul, centre[l], ur, ml, mr, dl, centre[l+2], dr, centre[l+1]);
+        out[l] = result;
+        alive |= result;
+        changed |= result ^ centre[l+1];
+    }
+    c->alive = alive;
+    c->changed = changed;
+}
+
+//The job run by each thread of the pool: it steps its share of the plane's chunks.
+static void sparse_step_chunks(void *arg, int id, int threads){
+    Sparse *s = (Sparse *)arg;
+    size_t first = s->count * (size_t)id / (size_t)threads, end = s->count * (size_t)(id + 1) / (size_t)threads;
+    for(size_t i=first; i<end; i++){
+        sparse_step_chunk(s, s->chunks[i]);
+    }
+}
+
+//Moves the plane on one generation. First the empty chunks that live cells on the edge of a chunk could spread into are made. Then every chunk finds its neighbours and the chunks are stepped, shared out over the pool's threads. Finally the chunks that have died out are freed, so the plane only ever holds the live part of the pattern and the ring of chunks around it.
+void sparse_step(Sparse *s, Thread_pool *pool){
+    static const int offsets[8][2] = {{-1,-1}, {-1,0}, {-1,1}, {0,-1}, {0,1}, {1,-1}, {1,0}, {1,1}};
+    size_t live = s->count;
+    int changed = 0;
+    
+    for(size_t i=0; i<live; i++){
+        Chunk *c = s->chunks[i];
+        const uint64_t *rows = c->rows[s->current];
+        uint64_t west = 0, east = 0;
+        for(int l=0; l<CHUNK_SIZE; l++){
+            west |= rows[l] & 1;
+            east |= rows[l] >> 63;
+        }
+        int64_t cl = c->cl, cw = c->cw;
+        int edge[8] = {(int)(rows[0] & 1), rows[0] != 0, (int)(rows[0] >> 63), (int)west, (int)east, (int)(rows[CHUNK_SIZE-1] & 1), rows[CHUNK_SIZE-1] != 0, (int)(rows[CHUNK_SIZE-1] >> 63)};
+        for(int d=0; d<8; d++){
+            if (edge[d]) {
+                sparse_chunk(s, cl + offsets[d][0], cw + offsets[d][1], 1);
+            }
+        }
+    }
+    for(size_t i=0; i<s->count; i++){
+        Chunk *c = s->chunks[i];
+        for(int d=0; d<8; d++){
+            c->around[d] = sparse_chunk(s, c->cl + offsets[d][0], c->cw + offsets[d][1], 0);
+        }
+    }
+    
+    if (pool == NULL || pool->threads == 1 || s->count < 2) {
+        sparse_step_chunks(s, 0, 1);
+    }
+    else{
+        pool_run(pool, sparse_step_chunks, s);
+    }
+    
+    s->current = !s->current;
+    for(size_t i=s->count; i-- > 0;){
+        Chunk *c = s->chunks[i];
+        changed |= (c->changed != 0);
+        if (c->alive == 0) {
+            sparse_remove(s, c);
+        }
+    }
+    s->changed = changed;
+    s->generation += 1;
+}
+
+//Counts the live cells on the plane.
+uint64_t sparse_population(const Sparse *s){
+    uint64_t population = 0;
+    for(size_t i=0; i<s->count; i++){
+        for(int l=0; l<CHUNK_SIZE; l++){
+            population += (uint64_t)__builtin_popcountll(s->chunks[i]->rows[s->current][l]);
+        }
+    }
+    return population;
+}
+
+//Puts the live cells of a board onto an empty plane, with the top left of the board at (0, 0). A chunk is as wide as a word of the board, so whole words are copied across.
+void sparse_load(Sparse *s, Grid_info *g){
+    size_t words = ((size_t)g->wid + WORD_BITS - 1) / WORD_BITS;
+    for(int l=0; l<g->len; l++){
+        for(size_t k=0; k<words; k++){
+            uint64_t bits = g->grid[(size_t)l * g->stride + k];
+            if (bits != 0) {
+                sparse_chunk(s, l >> 6, (int64_t)k, 1)->rows[s->current][l & 63] = bits;
+            }
+        }
+    }
+}
+
+//Copies the part of the plane from (0, 0) to (len-1, wid-1) into a board, so the board works as a window onto the plane. Cells past the width of the board are cut off to keep the padding bits zero.
+void sparse_view(const Sparse *s, Grid_info *g, uint64_t *board){
+    size_t words = ((size_t)g->wid + WORD_BITS - 1) / WORD_BITS;
+    int last = (g->wid - 1) % WORD_BITS;
+    
+    memset(board, 0, (size_t)g->len * g->stride * sizeof(uint64_t));
+    for(size_t i=0; i<s->count; i++){
+        const Chunk *c = s->chunks[i];
+        if (c->cl < 0 || c->cw < 0 || c->cl * CHUNK_SIZE >= g->len || (size_t)c->cw >= words) {
+            continue;
+        }
+        uint64_t mask = ((size_t)c->cw + 1 == words && last != WORD_BITS - 1) ? ((uint64_t)1 << (last + 1)) - 1 : ~(uint64_t)0;
+        for(int l=0; l<CHUNK_SIZE && c->cl * CHUNK_SIZE + l < g->len; l++){
+            board[(size_t)(c->cl * CHUNK_SIZE + l) * g->stride + (size_t)c->cw] = c->rows[s->current][l] & mask;
+        }
+    }
+}
+
+//The node limit for HashLife can be set with the GOL_HASHLIFE_NODES environment variable. It defaults to about four million nodes, which is a few hundred megabytes.
+size_t hashlife_nodes(void){
+    const char *env = getenv("GOL_HASHLIFE_NODES");
+    if (env != NULL && atol(env) > 0) {
+        return (size_t)atol(env);
+    }
+    return (size_t)1 << 22;
+}
+
+//This function asks how far to jump and moves the board on by 2^k generations with HashLife, then prints where the pattern has got to. HashLife works on an unbounded plane, so unlike the normal game the edges of the board don't wrap round, and anything that leaves the board is not shown.
+void fast_forward(Grid_info *g){
+    Hashlife hl;
+    
+    printf("How far do you want to jump? Enter k to move on 2^k generations (max %d)\n", HL_MAX_JUMP);
+    int k = input(0,HL_MAX_JUMP);
+    if (hl_init(&hl, hashlife_nodes()) != 0) {
+        printf("Out of memory!\n");
+        return;
+    }
+    hl_load(&hl, g);
+    if (hl_advance(&hl, k) != 0) {
+        printf("The pattern grew too big to jump that far.\n");
+    }
+    else{
+        hl_store(&hl, g);
+        print_board(g);
+        printf("Generation %llu, population %llu\n", (unsigned long long)hl.generation, (unsigned long long)hl.root->population);
+    }
+    hl_free(&hl);
+}
+
+//Counts the live cells on the board a word at a time.
+uint64_t population(Grid_info *g){
+    uint64_t count = 0;
+    for(size_t i=0; i<(size_t)g->len * g->stride; i++){
+        count += (uint64_t)__builtin_popcountll(g->grid[i]);
+    }
+    return count;
+}
+
+//The checkpoint thread. It sleeps until a copy of the board is handed over, writes it out, and goes back to sleep, until it is told to quit.
+static void *checkpoint_worker(void *arg){
+    Checkpointer *c = (Checkpointer *)arg;
+    size_t size = strlen(c->path) + 5;
+    char *temporary = (char *)malloc(size);
+    
+    pthread_mutex_lock(&c->lock);
+    while (1) {
+        while (c->busy == 0 && c->quit == 0) {
+            pthread_cond_wait(&c->wake, &c->lock);
+        }
+        if (c->busy == 0) {
+            break;
+        }
+        pthread_mutex_unlock(&c->lock);
+        int failed = (temporary == NULL);
+        if (failed == 0) {
+            snprintf(temporary, size, "%s.tmp", c->path);
+            failed = save_packed(&c->copy, temporary) != 0 || rename(temporary, c->path) != 0;
+        }
+        pthread_mutex_lock(&c->lock);
+        c->written += !failed;
+        c->failed += failed;
+        c->busy = 0;
+        pthread_cond_broadcast(&c->wake);
+    }
+    pthread_mutex_unlock(&c->lock);
+    free(temporary);
+    return NULL;
+}
+
+//Starts the checkpoint thread, which will write to path. It returns -1 if the thread could not be started.
+int checkpoint_start(Checkpointer *c, const char *path){
+    memset(c, 0, sizeof(Checkpointer));
+    c->path = path;
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->wake, NULL);
+    if (pthread_create(&c->thread, NULL, checkpoint_worker, c) != 0) {
+        pthread_mutex_destroy(&c->lock);
+        pthread_cond_destroy(&c->wake);
+        return -1;
+    }
+    return 0;
+}
+
+//Copies this thread's share of the words, in whole cache lines where it can.
+static void copy_words(void *arg, int id, int threads){
+    Copy_job *job = (Copy_job *)arg;
+    size_t lines = (job->words + ROW_ALIGN_WORDS - 1) / ROW_ALIGN_WORDS;
+    size_t first = lines * (size_t)id / (size_t)threads * ROW_ALIGN_WORDS, end = lines * ((size_t)id + 1) / (size_t)threads * ROW_ALIGN_WORDS;
+    end = (end < job->words) ? end : job->words;
+    if (first < end) {
+        memcpy(job->to + first, job->from + first, (end - first) * sizeof(uint64_t));
+    }
+}
+
+//Hands a copy of the board to the checkpoint thread to be written out. If the last checkpoint is still being written this one is skipped, so the game never waits for the disk. If wait is set it waits for the thread to be free instead, which is used for the last checkpoint of a run. The copy is shared out over the board's thread pool, which is idle between generations, so a big board is copied at the speed of memory rather than of one thread.
+void checkpoint_offer(Checkpointer *c, Grid_info *g, int wait){
+    size_t words = (size_t)g->len * g->stride;
+    Copy_job job;
+    
+    pthread_mutex_lock(&c->lock);
+    while (wait && c->busy) {
+        pthread_cond_wait(&c->wake, &c->lock);
+    }
+    if (c->busy) {
+        c->skipped += 1;
+        pthread_mutex_unlock(&c->lock);
+        return;
+    }
+    pthread_mutex_unlock(&c->lock);
+    
+    //The thread is idle, so the copy can be filled in without the lock.
+    if (words > c->capacity) {
+        free(c->copy.grid);
+        c->copy.grid = (uint64_t *)malloc(words * sizeof(uint64_t));
+        c->capacity = (c->copy.grid == NULL) ? 0 : words;
+        if (c->copy.grid == NULL) {
+            printf("Out of memory!\n");
+            c->failed += 1;
+            return;
+        }
+    }
+    job.to = c->copy.grid;
+    job.from = g->grid;
+    job.words = words;
+    pool_run(g->pool, copy_words, &job);
+    c->copy.len = g->len;
+    c->copy.wid = g->wid;
+    c->copy.stride = g->stride;
+    c->copy.generation = g->generation;
+    
+    pthread_mutex_lock(&c->lock);
+    c->busy = 1;
+    pthread_cond_signal(&c->wake);
+    pthread_mutex_unlock(&c->lock);
+}
+
+//Waits for any checkpoint still being written, then stops the thread.
+void checkpoint_stop(Checkpointer *c){
+    pthread_mutex_lock(&c->lock);
+    c->quit = 1;
+    pthread_cond_broadcast(&c->wake);
+    pthread_mutex_unlock(&c->lock);
+    pthread_join(c->thread, NULL);
+    pthread_mutex_destroy(&c->lock);
+    pthread_cond_destroy(&c->wake);
+    free(c->copy.grid);
+    c->copy.grid = NULL;
+}
+
+//Runs the game without the menu, for use from scripts and job schedulers. The board is read from a file and run until it reaches the given generation (stopping early if it stops changing, or starts repeating a cycle of up to CYCLE_HISTORY generations) without printing or sleeping, then the final board is written out if asked and the population and timing are reported. Boards from text and RLE files start at generation 0, and snapshots carry on from the generation they were saved at.
+//With -c, a snapshot of the board is written to the checkpoint file every n generations (-n) and/or every s seconds (-s), and once more at the end, by a background thread so the run doesn't wait for it. With -r, the run carries on from the checkpoint file if there is a readable one, and starts from the input file otherwise, so a job that was stopped can simply be started again with the same options.
+//With -d, every generation is written to a delta stream (see delta_frame()) that game replay can turn back into boards.
+//With -v, a live view of the board is drawn by the fast renderer on its own thread at GOL_FPS frames a second while the board runs at full speed, zoomed out to fit the terminal if the board is too big. -w shows a window from the cell at (top, left) instead, at the given zoom (1 for exact braille cells, more for a shaded density map, 0 to fit).
+//With -x, the board is exported as images every e generations (-e, every generation by default), starting with the board it starts from, with each cell drawn as z by z pixels (-z). The frames are encoded by a pool of threads of their own (see export_start()), so a frame costs the stepping thread little more than a copy of the board. There are -j of them, or by default as many as the processors the stepping threads leave free (see export_threads()).
+//With -S, the population, births, deaths and box around the live cells of every generation are written to a time series (see stats_record()) that game stats prints out. They are counted by the threads as they step the board.
+//The board is run with the rule from GOL_RULE, unless the input file (or checkpoint) names one, and -R overrides both with a rule in B/S notation such as B36/S23.
+//Usage: game batch -i input [-g generations] [-o output] [-t threads] [-c checkpoint [-n generations] [-s seconds] [-r]] [-d deltas] [-v | -w top,left,zoom] [-x frames [-z zoom] [-e generations] [-j encoders]] [-R rule] [-S series]
+int batch(int argc, char *argv[]){
+    const char *in = NULL, *out = NULL, *checkpoint = NULL, *deltas = NULL, *frames = NULL, *rule = NULL, *series = NULL;
+    FILE *stream = NULL, *series_file = NULL;
+    Live_view live;
+    Exporter exporter;
+    int view = 0, top = 0, left = 0, zoom = 0, scale = 1;
+    long generations = 100, every = 0, export_every = 1, j = 0;
+    double seconds = 0;
+    int threads = thread_count(), encoders = 0, option, resume = 0, loaded = -1;
+    Grid_info g;
+    Checkpointer c;
+    History history;
+    Board_stats stats;
+    uint64_t period = 0, cycle_start = 0;
+    
+    //getopt() skips its first argument as the program name, so starting from "batch" leaves just the options.
+    while ((option = getopt(argc - 1, argv + 1, "i:g:o:t:c:n:s:rd:vw:x:z:e:j:R:S:")) != -1) {
+        switch (option) {
+            case 'i': in = optarg; break;
+            case 'g': generations = atol(optarg); break;
+            case 'o': out = optarg; break;
+            case 't': threads = atoi(optarg); break;
+            case 'c': checkpoint = optarg; break;
+            case 'n': every = atol(optarg); break;
+            case 's': seconds = atof(optarg); break;
+            case 'r': resume = 1; break;
+            case 'd': deltas = optarg; break;
+            case 'v': view = 1; break;
+            case 'w': view = 1; generations = (sscanf(optarg, "%d,%d,%d", &top, &left, &zoom) == 3) ? generations : -1; break;
+            case 'x': frames = optarg; break;
+            case 'z': scale = atoi(optarg); break;
+            case 'e': export_every = atol(optarg); break;
+            case 'j': encoders = atoi(optarg); break;
+            case 'R': rule = optarg; break;
+            case 'S': series = optarg; break;
+            default: generations = -1; break;
+        }
+    }
+    if (in == NULL || generations < 0 || threads < 1 || every < 0 || seconds < 0 || ((resume || every || seconds > 0) && checkpoint == NULL) || scale < 1 || export_every < 1 || encoders < 0) {
+        printf("Usage: game batch -i input [-g generations] [-o output] [-t threads] [-c checkpoint [-n generations] [-s seconds] [-r]] [-d deltas] [-v | -w top,left,zoom] [-x frames [-z zoom] [-e generations] [-j encoders]] [-R rule] [-S series]\n");
+        return -1;
+    }
+    if (grid_alloc(&g, 1, 1) != 0) {
+        printf("Out of memory!\n");
+        return -1;
+    }
+    //The pool is started first so that compressed snapshots are unpacked on all the threads.
+    g.pool = pool_create(threads);
+    if (g.pool == NULL) {
+        printf("Could not start the worker threads!\n");
+        grid_free(&g);
+        return -1;
+    }
+    if (resume && access(checkpoint, R_OK) == 0) {
+        loaded = load_snapshot(&g, checkpoint);
+        if (loaded == 0) {
+            printf("Resuming from %s at generation %llu\n", checkpoint, (unsigned long long)g.generation);
+        }
+    }
+    if ((loaded != 0 && load_board(&g, in) != 0) || (rule != NULL && set_rule(rule) != 0)) {
+        pool_destroy(g.pool);
+        grid_free(&g);
+        return -1;
+    }
+    if (deltas != NULL) {
+        stream = fopen(deltas, "wb");
+        if (stream == NULL) {
+            printf("Could not open %s\n", deltas);
+            pool_destroy(g.pool);
+            grid_free(&g);
+            return -1;
+        }
+        delta_start(stream, &g);
+    }
+    if (series != NULL) {
+        series_file = fopen(series, "wb");
+        if (series_file == NULL || stats_init(&stats, &g) != 0) {
+            printf((series_file == NULL) ? "Could not open %s\n" : "Out of memory!\n", series);
+            if (series_file != NULL) {
+                fclose(series_file);
+            }
+            if (stream != NULL) {
+                fclose(stream);
+            }
+            pool_destroy(g.pool);
+            grid_free(&g);
+            return -1;
+        }
+        stats_start(series_file, &g);
+    }
+    if (frames != NULL && export_start(&exporter, &g, frames, scale, (encoders > 0) ? encoders : export_threads(threads)) != 0) {
+        printf("Could not start exporting frames!\n");
+        frames = NULL;
+    }
+    if (frames != NULL) {
+        export_frame(&exporter, &g);
+    }
+    if (view && view_start(&live, &g, top, left, zoom) != 0) {
+        printf("Could not start the live view!\n");
+        view = 0;
+    }
+    if (checkpoint != NULL && checkpoint_start(&c, checkpoint) != 0) {
+        printf("Could not start the checkpoint thread!\n");
+        checkpoint = NULL;
+    }
+    
+    int cycles = history_init(&history, CYCLE_HISTORY) == 0;
+    if (cycles) {
+        history_start(&history, &g);
+    }
+    
+    double start = now_seconds(), last_checkpoint = start;
+    int changed = 1;
+    while ((long)g.generation < generations && changed && period == 0) {
+        next(&g);
+        changed = board_changed(&g);
+        if (cycles) {
+            period = history_step(&history, &g, &cycle_start);
+        }
+        if (stream != NULL) {
+            delta_frame(stream, &g, g.grid, g.next_grid, g.plane == NULL);
+        }
+        if (series_file != NULL) {
+            stats_record(series_file, &stats);
+        }
+        advance(&g);
+        if (view) {
+            view_offer(&live, &g, 0);
+        }
+        if (frames != NULL && g.generation % (uint64_t)export_every == 0) {
+            export_frame(&exporter, &g);
+        }
+        j += 1;
+        if (checkpoint != NULL && ((every > 0 && g.generation % (uint64_t)every == 0) || (seconds > 0 && now_seconds() - last_checkpoint >= seconds))) {
+            checkpoint_offer(&c, &g, 0);
+            last_checkpoint = now_seconds();
+        }
+    }
+    double time = now_seconds() - start;
+    if (view) {
+        view_stop(&live, &g);
+        printf("Live view drew %ld frames and skipped %ld generations\n", live.drawn, live.skipped);
+    }
+    if (stream != NULL && fclose(stream) != 0) {
+        printf("Could not write %s\n", deltas);
+    }
+    if (series_file != NULL) {
+        stats_free(&stats, &g);
+        if (fclose(series_file) != 0) {
+            printf("Could not write %s\n", series);
+        }
+    }
+    if (frames != NULL) {
+        long exported = exporter.next_sequence;
+        printf((export_finish(&exporter) == 0) ? "%ld frames exported to %s\n" : "Could not write all %ld frames to %s\n", exported, frames);
+    }
+    if (checkpoint != NULL) {
+        checkpoint_offer(&c, &g, 1);
+        checkpoint_stop(&c);
+        printf("%d checkpoints written to %s (%d skipped while busy, %d failed)\n", c.written, checkpoint, c.skipped, c.failed);
+    }
+    
+    printf("%dx%d board, rule %s, %ld generations%s on %d threads\n", g.len, g.wid, life_rule.name, j, changed ? "" : " (stopped changing)", g.pool->threads);
+    if (changed && period > 0) {
+        printf("The board repeats every %llu generations from generation %llu\n", (unsigned long long)period, (unsigned long long)cycle_start);
+    }
+    printf("Generation %llu, population %llu\n", (unsigned long long)g.generation, (unsigned long long)population(&g));
+    printf("Time %.3f s, %.3e cell updates/s\n", time, (time > 0) ? (double)g.len * g.wid * j / time : 0.0);
+    int status = (out != NULL) ? save_board(&g, out) : 0;
+    if (cycles) {
+        history_free(&history);
+    }
+    pool_destroy(g.pool);
+    grid_free(&g);
+    return status;
+}
+
+//Seeds a random number generator from one number, using splitmix64 to spread it over the four words of state (which must never all be zero).
+void rng_seed(Rng *r, uint64_t seed){
+    for(int i=0; i<4; i++){
+        uint64_t z = (seed += 0x9e3779b97f4a7c15u);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+        r->s[i] = z ^ (z >> 31);
+    }
+}
+
+//Returns the next 64 random bits.
+uint64_t rng_next(Rng *r){
+    uint64_t result = r->s[1] * 5;
+    result = ((result << 7) | (result >> 57)) * 9;
+    uint64_t t = r->s[1] << 17;
+    r->s[2] ^= r->s[0];
+    r->s[3] ^= r->s[1];
+    r->s[1] ^= r->s[2];
+    r->s[0] ^= r->s[3];
+    r->s[2] ^= t;
+    r->s[3] = (r->s[3] << 45) | (r->s[3] >> 19);
+    return result;
+}
+
+//Puts a soup of size by size random cells in the middle of an empty board, taking up to 64 cells at a time from the generator and putting them straight into the words of the row.
+void soup_fill(Grid_info *g, Rng *r, int size){
+    int top = (g->len - size) / 2, left = (g->wid - size) / 2;
+    for(int l=top; l<top+size; l++){
+        uint64_t *row = g->grid + (size_t)l * g->stride;
+        for(int c=0; c<size; c+=WORD_BITS){
+            int n = (size - c < WORD_BITS) ? size - c : WORD_BITS, w = left + c, shift = w % WORD_BITS;
+            uint64_t bits = rng_next(r) & ((n == WORD_BITS) ? ~(uint64_t)0 : ((uint64_t)1 << n) - 1);
+            row[w / WORD_BITS] |= bits << shift;
+            if (shift != 0 && n > WORD_BITS - shift) {
+                row[w / WORD_BITS + 1] |= bits >> (WORD_BITS - shift);
+            }
+        }
+    }
+}
+
+//Sets up a lockstep of 64 empty boards of len by wid cells. It returns -1 if the memory could not be found.
+int lockstep_init(Lockstep *k, int len, int wid){
+    size_t words = (size_t)(len + 2) * (size_t)(wid + 2);
+    memset(k, 0, sizeof(Lockstep));
+    k->len = len;
+    k->wid = wid;
+    k->stride = (size_t)wid + 2;
+    k->cells = (uint64_t *)calloc(words, sizeof(uint64_t));
+    k->next_cells = (uint64_t *)calloc(words, sizeof(uint64_t));
+    k->before = (uint64_t *)calloc(words, sizeof(uint64_t));
+    if (k->cells == NULL || k->next_cells == NULL || k->before == NULL) {
+        lockstep_free(k);
+        return -1;
+    }
+    return 0;
+}
+
+//Frees the boards of a lockstep.
+void lockstep_free(Lockstep *k){
+    free(k->cells);
+    free(k->next_cells);
+    free(k->before);
+    k->cells = NULL;
+    k->next_cells = NULL;
+    k->before = NULL;
+}
+
+//Clears every board of a lockstep, ready for new boards to be put in.
+void lockstep_clear(Lockstep *k){
+    memset(k->cells, 0, (size_t)(k->len + 2) * k->stride * sizeof(uint64_t));
+    k->running = 0;
+    k->generation = 0;
+}
+
+//Sets the cell at row l and column w of one board of a lockstep to the value given (0 or 1).
+void lockstep_set(Lockstep *k, int board, int l, int w, int value){
+    uint64_t *word = k->cells + (size_t)(l + 1) * k->stride + (size_t)w + 1;
+    *word = (*word & ~((uint64_t)1 << board)) | ((uint64_t)value << board);
+}
+
+//Returns the state (0 or 1) of the cell at row l and column w of one board of a lockstep.
+int lockstep_cell(const Lockstep *k, int board, int l, int w){
+    return (int)((k->cells[(size_t)(l + 1) * k->stride + (size_t)w + 1] >> board) & 1);
+}
+
+//Fills in the ghost cells of a set of lockstep boards from the cells on the other side: first the two ends of every row, then the ghost rows (corners included) from the last and first rows.
+static void lockstep_wrap(Lockstep *k, uint64_t *cells){
+    for(int l=1; l<=k->len; l++){
+        uint64_t *row = cells + (size_t)l * k->stride;
+        row[0] = row[k->wid];
+        row[k->wid + 1] = row[1];
+    }
+    memcpy(cells, cells + (size_t)k->len * k->stride, k->stride * sizeof(uint64_t));
+    memcpy(cells + (size_t)(k->len + 1) * k->stride, cells + k->stride, k->stride * sizeof(uint64_t));
+}
+
+//Starts the first boards boards of a lockstep running from the cells that have been put in them.
+void lockstep_start(Lockstep *k, int boards){
+    lockstep_wrap(k, k->cells);
+    k->running = (boards >= 64) ? ~(uint64_t)0 : ((uint64_t)1 << boards) - 1;
+    k->generation = 0;
+    k->stopped = 0;
+    memset(k->lifespan, 0, sizeof(k->lifespan));
+    memset(k->period, 0, sizeof(k->period));
+}
+
+//Steps every board of a lockstep on one generation, a row at a time with step_lockstep, and stops the boards that came back to where they were one or two generations before. A board that hasn't changed settled a generation ago, and one that is back to where it was two generations ago settled two generations ago (the period 2 check needs a generation before the one stepped from, so it starts a generation in).
+void lockstep_step(Lockstep *k){
+    uint64_t found[2] = {0, 0};
+    for(int l=1; l<=k->len; l++){
+        size_t row = (size_t)l * k->stride;
+        step_lockstep(k->cells + row - k->stride, k->cells + row, k->cells + row + k->stride, k->before + row, k->next_cells + row, k->wid, k->running, found);
+    }
+    lockstep_wrap(k, k->next_cells);
+    uint64_t still = k->running & ~found[0];
+    uint64_t twos = (k->generation == 0) ? 0 : k->running & ~still & ~found[1];
+    for(uint64_t stopped=still|twos; stopped!=0; stopped&=stopped-1){
+        int b = __builtin_ctzll(stopped);
+        k->period[b] = ((still >> b) & 1) ? 1 : 2;
+        k->lifespan[b] = (uint32_t)(k->generation + 1 - k->period[b]);
+    }
+    k->running &= ~(still | twos);
+    k->stopped = ((still | twos) != 0) ? 0 : k->stopped + 1;
+    
+    uint64_t *board = k->before;
+    k->before = k->cells;
+    k->cells = k->next_cells;
+    k->next_cells = board;
+    k->generation += 1;
+}
+
+//Steps a lockstep until every board has stopped, generation limit is reached, or patience generations go by without any board stopping. Boards still running at the end are given that generation as their lifespan and a period of 0.
+void lockstep_run(Lockstep *k, uint64_t limit, uint64_t patience){
+    while (k->running != 0 && k->generation < limit && k->stopped < patience) {
+        lockstep_step(k);
+    }
+    for(uint64_t left=k->running; left!=0; left&=left-1){
+        k->lifespan[__builtin_ctzll(left)] = (uint32_t)k->generation;
+    }
+}
+
+//Counts the live cells of every board of a lockstep.
+void lockstep_population(const Lockstep *k, uint32_t counts[64]){
+    memset(counts, 0, 64 * sizeof(uint32_t));
+    for(int l=1; l<=k->len; l++){
+        for(int w=1; w<=k->wid; w++){
+            for(uint64_t bits=k->cells[(size_t)l * k->stride + (size_t)w]; bits!=0; bits&=bits-1){
+                counts[__builtin_ctzll(bits)] += 1;
+            }
+        }
+    }
+}
+
+//Puts a soup into one board of a lockstep, taking the random bits in the same order as soup_fill() does, so the same generator gives the same soup.
+void lockstep_fill(Lockstep *k, int board, Rng *r, int size){
+    int top = (k->len - size) / 2, left = (k->wid - size) / 2;
+    for(int l=top; l<top+size; l++){
+        for(int c=0; c<size; c+=WORD_BITS){
+            int n = (size - c < WORD_BITS) ? size - c : WORD_BITS;
+            uint64_t bits = rng_next(r);
+            for(int x=0; x<n; x++){
+                lockstep_set(k, board, l, left + c + x, (int)((bits >> x) & 1));
+            }
+        }
+    }
+}
+
+//Copies one board of a lockstep onto g, which is resized to fit, and carries on from the lockstep's generation. It returns -1 if the memory could not be found.
+int lockstep_copy(const Lockstep *k, int board, Grid_info *g){
+    if (grid_resize(g, k->len, k->wid) != 0) {
+        return -1;
+    }
+    for(int l=0; l<k->len; l++){
+        for(int w=0; w<k->wid; w++){
+            set_cell(g->grid, g->stride, l, w, lockstep_cell(k, board, l, w));
+        }
+    }
+    g->generation = k->generation;
+    return 0;
+}
+
+//Runs a soup on from the generation it is at until it settles into a cycle or reaches generation limit, and fills in result. The history only knows the generations from where the soup is now, so if it isn't at generation 0, a cycle found starting from there may have started earlier.
+void soup_settle(Grid_info *g, History *h, uint64_t limit, Soup_result *result){
+    uint64_t period = 0, start = 0;
+    history_start(h, g);
+    while (period == 0 && g->generation < limit) {
+        next(g);
+        period = history_step(h, g, &start);
+        advance(g);
+    }
+    result->lifespan = (uint32_t)((period != 0) ? start : g->generation);
+    result->period = (uint32_t)period;
+    result->population = (uint32_t)population(g);
+}
+
+//One thread's share of a soup search. The thread takes blocks of 64 soups at a time until there are none left, and runs each one on its own board, with its own history to spot when the soup has settled into a cycle.
+void soup_run(void *arg, int id, int threads){
+    Soup_search *search = (Soup_search *)arg;
+    long first;
+    Grid_info g;
+    History h;
+    Rng r;
+    (void)id;
+    (void)threads;
+    
+    if (grid_alloc(&g, search->board, search->board) != 0) {
+        atomic_store(&search->failed, 1);
+        return;
+    }
+    if (history_init(&h, CYCLE_HISTORY) != 0) {
+        atomic_store(&search->failed, 1);
+        grid_free(&g);
+        return;
+    }
+    while ((first = atomic_fetch_add(&search->next, 64)) < search->count) {
+        long end = (first + 64 < search->count) ? first + 64 : search->count;
+        for(long i=first; i<end; i++){
+            grid_resize(&g, search->board, search->board);
+            rng_seed(&r, search->seed + (uint64_t)i);
+            soup_fill(&g, &r, search->size);
+            soup_settle(&g, &h, search->limit, &search->results[i]);
+        }
+    }
+    history_free(&h);
+    grid_free(&g);
+}
+
+//One thread's share of a soup search run in lockstep. The thread takes blocks of 64 soups at a time, as soup_run() does, and runs each block together on one Lockstep, which spots still lifes and cycles of period 2 but nothing longer. Once LOCKSTEP_PATIENCE generations go by without a board stopping, the boards still running are copied out and run on one at a time with a history, as soup_run() runs them. If one turns out to have been in its cycle already when it was copied out, the generation the cycle started at can't be told from there, so that soup is run again from the start. A soup that reaches the last generation without settling is run on a little further to make sure of that, since it may have settled into a long cycle before it was copied out and come round too late to be seen. Either way every soup comes out the same as it does from soup_run().
+void soup_run_lockstep(void *arg, int id, int threads){
+    Soup_search *search = (Soup_search *)arg;
+    uint32_t counts[64];
+    long first;
+    Lockstep k;
+    Grid_info g;
+    History h;
+    Rng r;
+    (void)id;
+    (void)threads;
+    
+    if (lockstep_init(&k, search->board, search->board) != 0) {
+        atomic_store(&search->failed, 1);
+        return;
+    }
+    if (grid_alloc(&g, search->board, search->board) != 0) {
+        atomic_store(&search->failed, 1);
+        lockstep_free(&k);
+        return;
+    }
+    if (history_init(&h, CYCLE_HISTORY) != 0) {
+        atomic_store(&search->failed, 1);
+        grid_free(&g);
+        lockstep_free(&k);
+        return;
+    }
+    while ((first = atomic_fetch_add(&search->next, 64)) < search->count) {
+        int boards = (first + 64 < search->count) ? 64 : (int)(search->count - first);
+        lockstep_clear(&k);
+        for(int b=0; b<boards; b++){
+            rng_seed(&r, search->seed + (uint64_t)(first + b));
+            lockstep_fill(&k, b, &r, search->size);
+        }
+        lockstep_start(&k, boards);
+        lockstep_run(&k, search->limit, LOCKSTEP_PATIENCE);
+        lockstep_population(&k, counts);
+        for(int b=0; b<boards; b++){
+            Soup_result *result = &search->results[first + b];
+            if (((k.running >> b) & 1) == 0) {
+                result->lifespan = k.lifespan[b];
+                result->period = k.period[b];
+                result->population = counts[b];
+                continue;
+            }
+            if (lockstep_copy(&k, b, &g) != 0) {
+                atomic_store(&search->failed, 1);
+                break;
+            }
+            soup_settle(&g, &h, search->limit, result);
+            uint64_t period = result->period, start = result->lifespan;
+            while (period == 0 && g.generation < k.generation + CYCLE_HISTORY) {
+                next(&g);
+                period = history_step(&h, &g, &start);
+                advance(&g);
+            }
+            if (period != 0 && start == k.generation && k.generation > 0) {
+                grid_resize(&g, search->board, search->board);
+                rng_seed(&r, search->seed + (uint64_t)(first + b));
+                soup_fill(&g, &r, search->size);
+                soup_settle(&g, &h, search->limit, result);
+            }
+        }
+    }
+    history_free(&h);
+    grid_free(&g);
+    lockstep_free(&k);
+}
+
+//Runs a soup search (see Soup_search) on the thread pool, or on this thread if pool is NULL. The results are allocated here and belong to the caller. It returns -1 if the memory could not be found.
+int soup_search(Soup_search *search, Thread_pool *pool){
+    search->results = (Soup_result *)malloc((size_t)search->count * sizeof(Soup_result));
+    if (search->results == NULL) {
+        return -1;
+    }
+    atomic_store(&search->next, 0);
+    atomic_store(&search->failed, 0);
+    pool_run(pool, search->lockstep ? soup_run_lockstep : soup_run, search);
+    if (atomic_load(&search->failed)) {
+        free(search->results);
+        search->results = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+//Searches through random soups for long-lived ones, with no menu. Each soup is run until it settles into a still life or a cycle of up to CYCLE_HISTORY generations, or reaches the given generation, and the number of soups a second is reported along with the longest lived soup. With -o, the lifespan, period and final population of every soup is written out as comma separated values, one line for each seed. The soups are numbered from the seed given with -S, so any soup can be run again on its own with the same options and -S set to its seed and -n 1.
+//With -L, the soups are run 64 at a time in lockstep (see Lockstep), which steps small boards many times faster. The lockstep only spots still lifes and cycles of period 2, so the soups that are left once the others have stopped are finished one at a time, and the results are the same as without -L.
+//Usage: game soup [-n soups] [-s size] [-b board] [-g generations] [-S seed] [-t threads] [-L] [-o summary]
+int soup(int argc, char *argv[]){
+    const char *out = NULL;
+    long generations = 10000;
+    int threads = thread_count(), option;
+    Soup_search search;
+    
+    memset(&search, 0, sizeof(search));
+    search.count = 10000;
+    search.size = 16;
+    search.board = 64;
+    while ((option = getopt(argc - 1, argv + 1, "n:s:b:g:S:t:Lo:")) != -1) {
+        switch (option) {
+            case 'n': search.count = atol(optarg); break;
+            case 's': search.size = atoi(optarg); break;
+            case 'b': search.board = atoi(optarg); break;
+            case 'g': generations = atol(optarg); break;
+            case 'S': search.seed = strtoull(optarg, NULL, 10); break;
+            case 't': threads = atoi(optarg); break;
+            case 'L': search.lockstep = 1; break;
+            case 'o': out = optarg; break;
+            default: search.count = -1; break;
+        }
+    }
+    if (search.count < 1 || search.size < 1 || search.board < search.size || search.board > MAX_DIMENSION || generations < 1 || generations > UINT32_MAX || threads < 1) {
+        printf("Usage: game soup [-n soups] [-s size] [-b board] [-g generations] [-S seed] [-t threads] [-L] [-o summary]\n");
+        return -1;
+    }
+    search.limit = (uint64_t)generations;
+    Thread_pool *pool = pool_create(threads);
+    if (pool == NULL) {
+        printf("Could not start the worker threads!\n");
+        return -1;
+    }
+    double start = now_seconds();
+    int failed = soup_search(&search, pool);
+    double time = now_seconds() - start;
+    pool_destroy(pool);
+    if (failed != 0) {
+        printf("Out of memory!\n");
+        return -1;
+    }
+    
+    long settled = 0, longest = 0;
+    for(long i=0; i<search.count; i++){
+        settled += (search.results[i].period != 0);
+        longest = (search.results[i].lifespan > search.results[longest].lifespan) ? i : longest;
+    }
+    printf("%ld soups of %dx%d on a %dx%d board%s in %.3f s on %d threads, %.0f soups/s\n", search.count, search.size, search.size, search.board, search.board, search.lockstep ? " in lockstep" : "", time, threads, (time > 0) ? (double)search.count / time : 0.0);
+    printf("%ld settled, %ld still running at generation %ld\n", settled, search.count - settled, generations);
+    printf("Longest lived: seed %llu, %s generation %u with population %u\n", (unsigned long long)(search.seed + (uint64_t)longest), search.results[longest].period ? "settled at" : "still running at", search.results[longest].lifespan, search.results[longest].population);
+    
+    int status = 0;
+    if (out != NULL) {
+        FILE *file = fopen(out, "w");
+        status = (file == NULL) ? -1 : 0;
+        if (file != NULL) {
+            fprintf(file, "seed,lifespan,period,population\n");
+            for(long i=0; i<search.count; i++){
+                fprintf(file, "%llu,%u,%u,%u\n", (unsigned long long)(search.seed + (uint64_t)i), search.results[i].lifespan, search.results[i].period, search.results[i].population);
+            }
+            status = (fclose(file) == 0) ? 0 : -1;
+        }
+        if (status != 0) {
+            printf("Could not write %s\n", out);
+        }
+    }
+    free(search.results);
+    return status;
+}
+
+//Fills the board with cells that are randomly alive or dead, in the same way as grid 1.
+void randomise(Grid_info *g){
+    for(int l=0; l<g->len; l++){
+        for(int w=0; w<g->wid; w++){
+            set_cell(g->grid, g->stride, l, w, rand() % 2);
+        }
+    }
+}
+
+//Returns a time in seconds from a clock that only ever goes forwards, for timing the kernels.
+double now_seconds(void){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+//Scatters soups (random squares of size by size cells) over an otherwise empty board, to make the kind of sparse, clustered board where most tiles are skipped.
+void scatter_soups(Grid_info *g, int soups, int size){
+    for(int i=0; i<soups; i++){
+        int top = rand() % g->len, left = rand() % g->wid;
+        for(int l=0; l<size; l++){
+            for(int w=0; w<size; w++){
+                set_cell(g->grid, g->stride, (top + l) % g->len, (left + w) % g->wid, rand() % 2);
+            }
+        }
+    }
+}
+
+//Runs the board in a through the cell-by-cell kernel and a copy of it in b through next(), comparing them after every generation. It returns 0 if they always match, or the first generation where they don't.
+int check_kernel(Grid_info *a, Grid_info *b, int generations){
+    memcpy(b->grid, a->grid, (size_t)a->len * a->stride * sizeof(uint64_t));
+    for(int j=0; j<generations; j++){
+        next_scalar(a);
+        next(b);
+        if (memcmp(a->next_grid, b->next_grid, (size_t)a->len * a->stride * sizeof(uint64_t)) != 0) {
+            return j + 1;
+        }
+        advance(a);
+        advance(b);
+    }
+    return 0;
+}
+
+//Checks the row kernels of each kind of rule against the cell-by-cell kernel, which uses the rule's lookup table: HighLife, Day & Night and Seeds on their own kernels and on the generic ones, and a rule with no kernel of its own (B36/S125, 2x2) on the generic ones. Every instruction set this processor has is checked on a few awkward board sizes. It then times HighLife on its own kernel against the generic one on a random board of size by size. The rule is put back to what it was at the end. It returns -1 if any kernel disagrees.
+int check_rules(Thread_pool *pool, int size, int generations){
+    const char *rules[] = {"B36/S23", "B3678/S34678", "B2/S", "B36/S125"};
+    const char *names[3] = {"swar", "avx2", "avx512"};
+    int sizes[][2] = {{3,5}, {17,63}, {40,65}, {64,130}, {9,1100}, {100,200}};
+    int count = (int)(sizeof(sizes) / sizeof(sizes[0])), available[3] = {1, 0, 0}, failed = 0;
+    Rule saved = life_rule;
+    Grid_info a, b;
+    
+#ifdef HAVE_X86_KERNELS
+    available[1] = __builtin_cpu_supports("avx2");
+    available[2] = __builtin_cpu_supports("avx512f");
+#endif
+    for(int i=0; i<(int)(sizeof(rules) / sizeof(rules[0])) && failed == 0; i++){
+        set_rule(rules[i]);
+        for(int n=0; n<3 && failed == 0; n++){
+            for(int generic=0; generic<2 && failed == 0; generic++){
+                if (available[n] == 0 || (generic == 0 && life_rule.kind == RULE_GENERIC)) {
+                    continue;
+                }
+                step_row = rule_kernels[generic ? RULE_GENERIC : life_rule.kind][n];
+                srand(3);
+                for(int s=0; s<count && failed == 0; s++){
+                    if (grid_alloc(&a, sizes[s][0], sizes[s][1]) != 0 || grid_alloc(&b, sizes[s][0], sizes[s][1]) != 0) {
+                        printf("Out of memory!\n");
+                        return -1;
+                    }
+                    randomise(&a);
+                    b.pool = pool;
+                    failed = check_kernel(&a, &b, 30);
+                    if (failed != 0) {
+                        printf("The %s%s kernel for %s disagrees with the cell-by-cell kernel on a %dx%d board at generation %d.\n", names[n], generic ? " generic" : "", life_rule.name, a.len, a.wid, failed);
+                    }
+                    grid_free(&a);
+                    grid_free(&b);
+                }
+            }
+        }
+        if (failed == 0) {
+            printf("The %s kernels for %s match the cell-by-cell kernel.\n", (life_rule.kind == RULE_GENERIC) ? "generic" : "specialised and generic", life_rule.name);
+        }
+    }
+    
+    if (failed == 0 && grid_alloc(&a, size, size) == 0) {
+        double times[2];
+        set_rule("B36/S23");
+        a.pool = pool;
+        int chosen = (strcmp(kernel_name, "avx512") == 0) ? 2 : (strcmp(kernel_name, "avx2") == 0) ? 1 : 0;
+        for(int generic=0; generic<2; generic++){
+            Row_kernel kernel = step_row;
+            srand(5);
+            randomise(&a);
+            step_row = rule_kernels[generic ? RULE_GENERIC : RULE_HIGHLIFE][chosen];
+            double start = now_seconds();
+            for(int j=0; j<generations; j++){
+                next(&a);
+            }
+            times[generic] = now_seconds() - start;
+            step_row = kernel;
+        }
+        printf("B36/S23 on a %dx%d board: %.3e cell updates/s on its own %s kernel, %.3e on the generic one (%.1fx)\n", size, size, (double)size * size * generations / times[0], kernel_name, (double)size * size * generations / times[1], times[1] / times[0]);
+        grid_free(&a);
+    }
+    life_rule = saved;
+    select_kernel();
+    return failed ? -1 : 0;
+}
+
+//Checks cycle detection. First the hash kept up to date from the changed words is checked against the hash worked out from scratch for every generation of a random board. Then a glider on a 20x20 board, which comes back to where it started after 80 generations, and a blinker, with period 2, must be found to cycle from generation 0. Last, a random soup is run until it settles into a cycle, and the board at the end is checked against the board at the generation the cycle was said to start at, by running a copy of the soup that far. It prints how long finding the cycle took against running on to 20000 generations, and returns -1 if anything is wrong. The checks are run under Conway's rules, whatever the rule is set to.
+int check_cycles(Thread_pool *pool){
+    Rule saved = life_rule;
+    int shapes[2][3][2] = {{{0,1}, {1,2}, {2,0}}, {{4,3}, {4,4}, {4,5}}}, expected[2] = {80, 2}, failed = 0;
+    uint64_t period = 0, start = 0;
+    History h;
+    Grid_info a, b;
+    
+    if (history_init(&h, CYCLE_HISTORY) != 0 || grid_alloc(&a, 200, 300) != 0 || grid_alloc(&b, 1, 1) != 0) {
+        printf("Out of memory!\n");
+        return -1;
+    }
+    set_rule("B3/S23");
+    a.pool = pool;
+    b.pool = pool;
+    srand(11);
+    randomise(&a);
+    history_start(&h, &a);
+    for(int j=0; j<300 && failed == 0; j++){
+        next(&a);
+        history_step(&h, &a, &start);
+        failed = h.hash != board_hash(&a, a.next_grid);
+        advance(&a);
+    }
+    if (failed) {
+        printf("The board hash kept up to date from the changed words is wrong.\n");
+    }
+    
+    for(int i=0; i<2 && failed == 0; i++){
+        grid_resize(&a, (i == 0) ? 20 : 10, (i == 0) ? 20 : 10);
+        set_cell(a.grid, a.stride, shapes[i][0][0], shapes[i][0][1], 1);
+        set_cell(a.grid, a.stride, shapes[i][1][0], shapes[i][1][1], 1);
+        set_cell(a.grid, a.stride, shapes[i][2][0], shapes[i][2][1], 1);
+        if (i == 0) {
+            set_cell(a.grid, a.stride, 2, 1, 1);
+            set_cell(a.grid, a.stride, 2, 2, 1);
+        }
+        history_start(&h, &a);
+        period = 0;
+        for(int j=0; j<200 && period == 0; j++){
+            next(&a);
+            period = history_step(&h, &a, &start);
+            advance(&a);
+        }
+        failed = period != (uint64_t)expected[i] || start != 0;
+        if (failed) {
+            printf("A %s was found to cycle every %llu generations from generation %llu, not every %d from 0.\n", (i == 0) ? "glider" : "blinker", (unsigned long long)period, (unsigned long long)start, expected[i]);
+        }
+    }
+    if (failed == 0) {
+        printf("Cycle detection finds a glider's period of 80 and a blinker's of 2.\n");
+    }
+    
+    if (failed == 0 && grid_resize(&a, 128, 128) == 0 && grid_resize(&b, 128, 128) == 0) {
+        srand(12);
+        scatter_soups(&a, 1, 48);
+        memcpy(b.grid, a.grid, (size_t)a.len * a.stride * sizeof(uint64_t));
+        history_start(&h, &a);
+        period = 0;
+        double begin = now_seconds();
+        while (a.generation < 20000 && period == 0) {
+            next(&a);
+            period = history_step(&h, &a, &start);
+            advance(&a);
+        }
+        double found = now_seconds() - begin;
+        uint64_t stopped = a.generation;
+        while (b.generation < start) {
+            next(&b);
+            advance(&b);
+        }
+        failed = period == 0 || memcmp(a.grid, b.grid, (size_t)a.len * a.stride * sizeof(uint64_t)) != 0;
+        begin = now_seconds();
+        while (a.generation < 20000) {
+            next(&a);
+            advance(&a);
+        }
+        if (failed) {
+            printf("A soup said to cycle every %llu generations from generation %llu doesn't.\n", (unsigned long long)period, (unsigned long long)start);
+        }
+        else{
+            printf("A 48x48 soup settled into a cycle of period %llu from generation %llu, found at generation %llu in %.3f s; running on to 20000 would take %.3f s more.\n", (unsigned long long)period, (unsigned long long)start, (unsigned long long)stopped, found, now_seconds() - begin);
+        }
+    }
+    history_free(&h);
+    grid_free(&a);
+    grid_free(&b);
+    life_rule = saved;
+    select_kernel();
+    return failed ? -1 : 0;
+}
+
+//Checks the statistics counted while stepping against ones worked out from the boards after every generation: on a random board, on a board with a few soups scattered over it (where most tiles are skipped) and on one narrower than a word. The board is stepped on the pool, so the threads' partials are checked too. It then times next() on a random board of size by size with and without the statistics. It returns -1 if they are ever wrong.
+int check_stats(Thread_pool *pool, int size, int generations){
+    int sizes[][2] = {{200,300}, {300,700}, {70,50}}, failed = 0;
+    Board_stats s;
+    Grid_info a;
+    
+    for(int i=0; i<3 && failed == 0; i++){
+        if (grid_alloc(&a, sizes[i][0], sizes[i][1]) != 0) {
+            printf("Out of memory!\n");
+            return -1;
+        }
+        a.pool = pool;
+        srand(13);
+        if (i == 1) {
+            scatter_soups(&a, 4, 40);
+        }
+        else{
+            randomise(&a);
+        }
+        if (stats_init(&s, &a) != 0) {
+            printf("Out of memory!\n");
+            grid_free(&a);
+            return -1;
+        }
+        for(int j=0; j<150 && failed == 0; j++){
+            uint64_t count = 0, births = 0, deaths = 0;
+            int box[4] = {-1, -1, -1, -1};
+            next(&a);
+            for(int l=0; l<a.len; l++){
+                for(int w=0; w<a.wid; w++){
+                    size_t word = (size_t)l * a.stride + (size_t)w / WORD_BITS;
+                    int before = (int)((a.grid[word] >> (w % WORD_BITS)) & 1), after = (int)((a.next_grid[word] >> (w % WORD_BITS)) & 1);
+                    count += (uint64_t)after;
+                    births += (uint64_t)(after && !before);
+                    deaths += (uint64_t)(before && !after);
+                    if (after) {
+                        box[0] = (box[0] < 0) ? l : box[0];
+                        box[1] = (box[1] < 0 || w < box[1]) ? w : box[1];
+                        box[2] = l;
+                        box[3] = (w > box[3]) ? w : box[3];
+                    }
+                }
+            }
+            failed = count != s.population || births != s.births || deaths != s.deaths || memcmp(box, s.box, sizeof(box)) != 0;
+            if (failed) {
+                printf("The statistics of a %dx%d board at generation %llu are population %llu, births %llu, deaths %llu, box %d,%d to %d,%d, not %llu, %llu, %llu, %d,%d to %d,%d.\n", a.len, a.wid, (unsigned long long)a.generation + 1, (unsigned long long)s.population, (unsigned long long)s.births, (unsigned long long)s.deaths, s.box[0], s.box[1], s.box[2], s.box[3], (unsigned long long)count, (unsigned long long)births, (unsigned long long)deaths, box[0], box[1], box[2], box[3]);
+            }
+            advance(&a);
+        }
+        stats_free(&s, &a);
+        grid_free(&a);
+    }
+    if (failed) {
+        return -1;
+    }
+    printf("The statistics counted while stepping match the boards on three board sizes.\n");
+    
+    if (grid_alloc(&a, size, size) != 0) {
+        printf("Out of memory!\n");
+        return -1;
+    }
+    a.pool = pool;
+    srand(14);
+    randomise(&a);
+    double times[2];
+    for(int counting=0; counting<2; counting++){
+        if (counting && stats_init(&s, &a) != 0) {
+            printf("Out of memory!\n");
+            grid_free(&a);
+            return -1;
+        }
+        double start = now_seconds();
+        for(int j=0; j<generations; j++){
+            next(&a);
+            advance(&a);
+        }
+        times[counting] = now_seconds() - start;
+    }
+    printf("Counting statistics on a %dx%d board: %.3f s for %d generations against %.3f s without (%.2fx).\n", size, size, times[1], generations, times[0], times[1] / times[0]);
+    stats_free(&s, &a);
+    grid_free(&a);
+    return 0;
+}
+
+//Runs the same soup search on one thread and on the pool, and checks that every soup comes out the same, since each soup's random cells come from its own seed rather than from whichever thread runs it. It prints the soups a second for both and returns -1 if they differ. The search is run under Conway's rules, whatever the rule is set to.
+int check_soups(Thread_pool *pool){
+    Rule saved = life_rule;
+    Soup_search one, many;
+    double times[2];
+    
+    set_rule("B3/S23");
+    memset(&one, 0, sizeof(one));
+    one.count = 400;
+    one.seed = 1000;
+    one.size = 16;
+    one.board = 64;
+    one.limit = 10000;
+    many = one;
+    double start = now_seconds();
+    if (soup_search(&one, NULL) != 0) {
+        printf("Out of memory!\n");
+        life_rule = saved;
+        select_kernel();
+        return -1;
+    }
+    times[0] = now_seconds() - start;
+    start = now_seconds();
+    if (soup_search(&many, pool) != 0) {
+        printf("Out of memory!\n");
+        free(one.results);
+        life_rule = saved;
+        select_kernel();
+        return -1;
+    }
+    times[1] = now_seconds() - start;
+    int failed = memcmp(one.results, many.results, (size_t)one.count * sizeof(Soup_result)) != 0;
+    if (failed) {
+        printf("A soup search on %d threads doesn't match the same search on one thread.\n", pool->threads);
+    }
+    else{
+        printf("Soup search: %ld 16x16 soups at %.0f soups/s on one thread and %.0f on %d, with the same results.\n", one.count, one.count / times[0], one.count / times[1], pool->threads);
+    }
+    free(one.results);
+    free(many.results);
+    life_rule = saved;
+    select_kernel();
+    return failed ? -1 : 0;
+}
+
+//Checks the lockstep kernels against next() by running the same soups both ways: one board at a time with full cycle detection, and 64 at a time in lockstep on every instruction set this processor has. Every soup must come out the same both ways, including the ones that settle into longer cycles, which the lockstep hands over to be run one at a time. This is done on a few board sizes, including ones that don't fill whole vectors, under Conway's rules, HighLife and a rule with no kernel of its own. It then times a sweep of 10x10 and 40x40 random boards (like grid 1) on one thread both ways. The rule is put back to what it was at the end. It returns -1 if they ever disagree.
+int check_lockstep(void){
+    const char *rules[] = {"B3/S23", "B36/S23", "B36/S125"};
+    const char *names[3] = {"swar", "avx2", "avx512"};
+    int sizes[][2] = {{10,10}, {13,20}, {37,37}, {16,70}}, available[3] = {1, 0, 0}, failed = 0;
+    Rule saved = life_rule;
+    Soup_search one, many;
+    
+#ifdef HAVE_X86_KERNELS
+    available[1] = __builtin_cpu_supports("avx2");
+    available[2] = __builtin_cpu_supports("avx512f");
+#endif
+    memset(&one, 0, sizeof(one));
+    one.count = 150;
+    one.limit = 300;
+    for(int i=0; i<3 && failed == 0; i++){
+        set_rule(rules[i]);
+        for(int z=0; z<4 && failed == 0; z++){
+            one.size = sizes[z][0];
+            one.board = sizes[z][1];
+            one.seed = (uint64_t)(100 * z);
+            one.lockstep = 0;
+            if (soup_search(&one, NULL) != 0) {
+                printf("Out of memory!\n");
+                return -1;
+            }
+            for(int n=0; n<3 && failed == 0; n++){
+                if (available[n] == 0) {
+                    continue;
+                }
+                step_lockstep = lockstep_kernels[life_rule.kind][n];
+                many = one;
+                many.lockstep = 1;
+                if (soup_search(&many, NULL) != 0) {
+                    printf("Out of memory!\n");
+                    free(one.results);
+                    return -1;
+                }
+                for(long j=0; j<one.count && failed == 0; j++){
+                    Soup_result a = one.results[j], b = many.results[j];
+                    failed = memcmp(&a, &b, sizeof(a)) != 0;
+                    if (failed) {
+                        printf("The %s lockstep kernel for %s disagrees with next() on soup %ld on a %dx%d board: lifespan %u, period %u, population %u against %u, %u, %u.\n", names[n], life_rule.name, j, one.board, one.board, b.lifespan, b.period, b.population, a.lifespan, a.period, a.population);
+                    }
+                }
+                free(many.results);
+            }
+            free(one.results);
+        }
+    }
+    life_rule = saved;
+    select_kernel();
+    if (failed) {
+        return -1;
+    }
+    printf("The lockstep soup search matches next() under 3 rules.\n");
+    
+    set_rule("B3/S23");
+    for(int size=10; size<=40; size+=30){
+        double times[2];
+        one.count = (size == 10) ? 6400 : 1280;
+        one.size = size;
+        one.board = size;
+        one.seed = 0;
+        one.limit = 1000;
+        for(int lockstep=0; lockstep<2; lockstep++){
+            one.lockstep = lockstep;
+            double start = now_seconds();
+            if (soup_search(&one, NULL) != 0) {
+                printf("Out of memory!\n");
+                life_rule = saved;
+                select_kernel();
+                return -1;
+            }
+            times[lockstep] = now_seconds() - start;
+            free(one.results);
+        }
+        printf("Lockstep: %ld random %dx%d boards on one thread at %.0f boards/s, against %.0f one at a time (%.1fx).\n", one.count, size, size, one.count / times[1], one.count / times[0], times[0] / times[1]);
+    }
+    life_rule = saved;
+    select_kernel();
+    return 0;
+}
+
+//Checks HashLife against next() on a random soup in the middle of a board big enough that nothing reaches the edges, so the wrap round doesn't come into it. HashLife is moved on 1, 2, 4... 64 generations at a time and the board is compared after each jump. It returns 0 if they always match, or the generation where they first don't. It then times one jump of 2^20 generations from a fresh soup, and checks a glider can be jumped the full 2^HL_MAX_JUMP generations, for Conway's rules only, since under rules like Seeds a soup never settles down and the jump would fill all of memory.
+uint64_t check_hashlife(Thread_pool *pool){
+    Grid_info a, b;
+    Hashlife hl;
+    uint64_t failed = 0;
+    
+    if (grid_alloc(&a, 1024, 1024) != 0 || grid_alloc(&b, 1024, 1024) != 0 || hl_init(&hl, hashlife_nodes()) != 0) {
+        printf("Out of memory!\n");
+        return 1;
+    }
+    b.pool = pool;
+    for(int l=496; l<528; l++){
+        for(int w=496; w<528; w++){
+            set_cell(b.grid, b.stride, l, w, rand() % 2);
+        }
+    }
+    hl_load(&hl, &b);
+    for(int k=0; k<=6 && failed == 0; k++){
+        for(int j=0; j<(1 << k); j++){
+            next(&b);
+            advance(&b);
+        }
+        if (hl_advance(&hl, k) != 0) {
+            failed = hl.generation;
+            break;
+        }
+        hl_store(&hl, &a);
+        if (memcmp(a.grid, b.grid, (size_t)a.len * a.stride * sizeof(uint64_t)) != 0) {
+            failed = hl.generation;
+        }
+    }
+    
+    if (failed == 0) {
+        printf("HashLife matches next() on jumps of 1 to 64 generations.\n");
+    }
+    if (failed == 0 && life_rule.kind == RULE_CONWAY) {
+        double start = now_seconds();
+        hl_load(&hl, &a);
+        hl_advance(&hl, 20);
+        printf("HashLife jumped a 32x32 soup on %llu generations in %.3f s (population %llu, %zu nodes).\n", (unsigned long long)hl.generation, now_seconds() - start, (unsigned long long)hl.root->population, hl.nodes);
+        
+        memset(a.grid, 0, (size_t)a.len * a.stride * sizeof(uint64_t));
+        set_cell(a.grid, a.stride, 0, 1, 1);
+        set_cell(a.grid, a.stride, 1, 2, 1);
+        set_cell(a.grid, a.stride, 2, 0, 1);
+        set_cell(a.grid, a.stride, 2, 1, 1);
+        set_cell(a.grid, a.stride, 2, 2, 1);
+        hl_load(&hl, &a);
+        if (hl_advance(&hl, HL_MAX_JUMP) != 0 || hl.generation != (uint64_t)1 << HL_MAX_JUMP || hl.root->population != 5) {
+            printf("HashLife couldn't jump a glider on 2^%d generations.\n", HL_MAX_JUMP);
+            failed = (uint64_t)1 << HL_MAX_JUMP;
+        }
+        else{
+            printf("HashLife jumped a glider on 2^%d generations.\n", HL_MAX_JUMP);
+        }
+    }
+    hl_free(&hl);
+    grid_free(&a);
+    grid_free(&b);
+    return failed;
+}
+
+//Checks the sparse plane against next() on a random soup in the middle of a board big enough that nothing reaches the edges, comparing the board with the window onto the plane after every generation. It returns 0 if they always match, or the first generation where they don't. It then times the plane on a larger soup whose gliders are left to fly off as far as they like.
+uint64_t check_sparse(Thread_pool *pool){
+    Grid_info a, b;
+    Sparse plane;
+    uint64_t failed = 0;
+    
+    if (grid_alloc(&a, 512, 512) != 0 || grid_alloc(&b, 512, 512) != 0 || sparse_init(&plane) != 0) {
+        printf("Out of memory!\n");
+        return 1;
+    }
+    a.pool = pool;
+    b.pool = pool;
+    for(int l=240; l<272; l++){
+        for(int w=240; w<272; w++){
+            set_cell(b.grid, b.stride, l, w, rand() % 2);
+        }
+    }
+    sparse_load(&plane, &b);
+    a.plane = &plane;
+    for(int j=0; j<200 && failed == 0; j++){
+        next(&a);
+        next(&b);
+        if (memcmp(a.next_grid, b.next_grid, (size_t)a.len * a.stride * sizeof(uint64_t)) != 0) {
+            failed = (uint64_t)j + 1;
+        }
+        advance(&a);
+        advance(&b);
+    }
+    sparse_free(&plane);
+    
+    if (failed == 0) {
+        printf("The sparse plane matches next() for 200 generations.\n");
+        if (sparse_init(&plane) != 0) {
+            printf("Out of memory!\n");
+            return 1;
+        }
+        for(int l=0; l<128; l++){
+            for(int w=0; w<128; w++){
+                sparse_set(&plane, l, w, rand() % 2);
+            }
+        }
+        double start = now_seconds();
+        for(int j=0; j<2000; j++){
+            sparse_step(&plane, pool);
+        }
+        printf("Sparse plane ran a 128x128 soup for 2000 generations in %.3f s (population %llu in %zu chunks).\n", now_seconds() - start, (unsigned long long)sparse_population(&plane), plane.count);
+        sparse_free(&plane);
+    }
+    grid_free(&a);
+    grid_free(&b);
+    return failed;
+}
+
+//Checks that compressed snapshots give back exactly the board that was saved, on boards that are empty, sparse and random, with edges that cut through blocks and words. It then saves and loads a 4096 by 4096 board of scattered soups and a random one on the thread pool, and prints how long that takes and how big the files are next to an uncompressed snapshot. It returns -1 if a board doesn't come back the same.
+int check_packed(Thread_pool *pool){
+    int sizes[][2] = {{1,1}, {5,70}, {255,257}, {256,256}, {300,1000}, {700,1500}};
+    int count = (int)(sizeof(sizes) / sizeof(sizes[0])), failed = 0;
+    char path[] = "/tmp/gol-packed-XXXXXX";
+    int file = mkstemp(path);
+    Grid_info a, b;
+    
+    if (file < 0) {
+        printf("Could not make a temporary file!\n");
+        return -1;
+    }
+    close(file);
+    if (grid_alloc(&a, 1, 1) != 0 || grid_alloc(&b, 1, 1) != 0) {
+        printf("Out of memory!\n");
+        unlink(path);
+        return -1;
+    }
+    a.pool = pool;
+    b.pool = pool;
+    for(int i=0; i<count * 3 && failed == 0; i++){
+        if (grid_resize(&a, sizes[i / 3][0], sizes[i / 3][1]) != 0) {
+            printf("Out of memory!\n");
+            failed = 1;
+            break;
+        }
+        if (i % 3 == 1) {
+            scatter_soups(&a, 3, 30);
+        }
+        else if (i % 3 == 2) {
+            randomise(&a);
+        }
+        a.generation = (uint64_t)i;
+        failed = save_packed(&a, path) != 0 || load_snapshot(&b, path) != 0 || b.len != a.len || b.wid != a.wid || b.generation != a.generation || memcmp(a.grid, b.grid, (size_t)a.len * a.stride * sizeof(uint64_t)) != 0;
+        if (failed) {
+            printf("A compressed snapshot of a %dx%d board doesn't load back the same.\n", a.len, a.wid);
+        }
+    }
+    if (failed == 0) {
+        printf("Compressed snapshots load back the same on %d boards.\n", count * 3);
+    }
+    
+    //A random 5x120 board is one block, which is stored as its words since hardly any of its bytes are empty, so setting the top bit of the first row (column 127) in the file must make the snapshot be turned down.
+    if (failed == 0 && grid_resize(&a, 5, 120) == 0) {
+        randomise(&a);
+        FILE *damage = (save_packed(&a, path) == 0) ? fopen(path, "r+b") : NULL;
+        failed = damage == NULL || fseek(damage, (long)(sizeof(Snapshot_header) + 2 * sizeof(uint64_t) + 1 + 2 * sizeof(uint64_t) - 1), SEEK_SET) != 0 || putc(0x80, damage) == EOF || fclose(damage) != 0;
+        failed = failed || load_snapshot(&b, path) == 0;
+        if (failed) {
+            printf("A compressed snapshot with cells past the width of the board was loaded.\n");
+        }
+    }
+    for(int i=0; i<2 && failed == 0; i++){
+        struct stat info;
+        if (grid_resize(&a, 4096, 4096) != 0) {
+            printf("Out of memory!\n");
+            failed = 1;
+            break;
+        }
+        if (i == 0) {
+            scatter_soups(&a, 16, 64);
+        }
+        else{
+            randomise(&a);
+        }
+        double start = now_seconds();
+        save_packed(&a, path);
+        double saved = now_seconds();
+        load_snapshot(&b, path);
+        double loaded = now_seconds();
+        stat(path, &info);
+        failed = memcmp(a.grid, b.grid, (size_t)a.len * a.stride * sizeof(uint64_t)) != 0;
+        printf("Compressed snapshot of a %s %dx%d board: %.1f KB (uncompressed %.1f KB), saved in %.3f s, loaded in %.3f s\n", (i == 0) ? "sparse" : "random", a.len, a.wid, (double)info.st_size / 1024, (double)(SNAPSHOT_HEADER + (size_t)a.len * a.stride * sizeof(uint64_t)) / 1024, saved - start, loaded - saved);
+    }
+    unlink(path);
+    grid_free(&a);
+    grid_free(&b);
+    return failed ? -1 : 0;
+}
+
+//Checks that boards written as RLE read back the same: empty, scattered and random boards of awkward sizes, under Conway's rules and HighLife, so the rule in the header has to be read back too. A file that is empty or only comments, has runs that go past the edges of the board, or has a rule that can't be run must be turned down, the last without touching the board. The rule is put back to what it was at the end. It returns -1 if anything doesn't match.
+int check_rle(void){
+    const char *rules[] = {"B3/S23", "B36/S23"};
+    int sizes[][2] = {{1,1}, {3,5}, {5,70}, {17,63}, {64,130}, {9,1100}, {255,257}};
+    int count = (int)(sizeof(sizes) / sizeof(sizes[0])), failed = 0;
+    char path[] = "/tmp/gol-rle-XXXXXX";
+    int file = mkstemp(path);
+    Rule saved = life_rule;
+    Grid_info a, b;
+    
+    if (file < 0) {
+        printf("Could not make a temporary file!\n");
+        return -1;
+    }
+    close(file);
+    if (grid_alloc(&a, 1, 1) != 0 || grid_alloc(&b, 1, 1) != 0) {
+        printf("Out of memory!\n");
+        unlink(path);
+        return -1;
+    }
+    srand(15);
+    for(int i=0; i<count * 3 * 2 && failed == 0; i++){
+        int size = i / 6, kind = (i / 2) % 3;
+        if (grid_resize(&a, sizes[size][0], sizes[size][1]) != 0) {
+            printf("Out of memory!\n");
+            failed = 1;
+            break;
+        }
+        if (kind == 1) {
+            scatter_soups(&a, 3, 30);
+        }
+        else if (kind == 2) {
+            randomise(&a);
+        }
+        set_rule(rules[i % 2]);
+        failed = save_rle(&a, path) != 0;
+        set_rule("B3/S23");
+        failed = failed || load_rle(&b, path) != 0 || b.len != a.len || b.wid != a.wid || strcmp(life_rule.name, rules[i % 2]) != 0 || memcmp(a.grid, b.grid, (size_t)a.len * a.stride * sizeof(uint64_t)) != 0;
+        if (failed) {
+            printf("An RLE file of a %dx%d board under %s doesn't read back the same.\n", a.len, a.wid, rules[i % 2]);
+        }
+    }
+    //The bad files: a header and the run repeated after it 2048 times, then a live cell. The long runs would carry the column or row round past the largest int if they weren't checked as they go.
+    const char *headers[] = {"", "#N Nothing\n#C but comments\n", "x = 10, y = 10\n", "x = 10, y = 10\n", "x = 3, y = 3, rule = B0/S\n"};
+    const char *runs[] = {"", "", "1048576b", "1048576$", ""};
+    const char *names[] = {"nothing in it", "only comments in it", "dead runs past the end of a row", "rows past the end of the board", "a rule that can't be run"};
+    for(int i=0; i<5 && failed == 0; i++){
+        FILE *out = fopen(path, "w");
+        if (out != NULL) {
+            fputs(headers[i], out);
+            for(int j=0; j<2048 && runs[i][0] != 0; j++){
+                fputs(runs[i], out);
+            }
+            fputs((i < 2) ? "" : "o!\n", out);
+            fclose(out);
+        }
+        int len = b.len;
+        failed = out == NULL || load_rle(&b, path) == 0 || (i == 4 && b.len != len);
+        if (failed) {
+            printf("An RLE file with %s was read as a board.\n", names[i]);
+        }
+    }
+    if (failed == 0) {
+        printf("RLE files read back the same on %d boards, with their rules.\n", count * 3 * 2);
+    }
+    unlink(path);
+    grid_free(&a);
+    grid_free(&b);
+    life_rule = saved;
+    select_kernel();
+    return failed ? -1 : 0;
+}
+
+//Times the renderer building whole frames of random boards of very different sizes, zoomed out to fit the terminal (or 80 by 24 characters), to show that the cost of a frame doesn't grow with the board. It also times exact braille frames of a small board as it changes, where only the changed rows are sent. The time the terminal takes to show the frames is left out.
+void time_render(Thread_pool *pool){
+    int sizes[2] = {1024, 16384}, frames = 200;
+    Grid_info a;
+    Renderer r;
+    
+    for(int i=0; i<3; i++){
+        size_t bytes = 0;
+        if (grid_alloc(&a, (i < 2) ? sizes[i] : 64, (i < 2) ? sizes[i] : 128) != 0 || render_init(&r, &a, 0, 0, (i < 2) ? 0 : 1) != 0) {
+            printf("Out of memory!\n");
+            return;
+        }
+        a.pool = pool;
+        randomise(&a);
+        double start = now_seconds();
+        for(int j=0; j<frames; j++){
+            if (i < 2) {
+                r.drawn = 0;
+            }
+            else{
+                next(&a);
+                advance(&a);
+            }
+            bytes += render_frame(&r, &a);
+        }
+        double time = now_seconds() - start;
+        printf("Renderer: %dx%d board as %dx%d characters at zoom %d, %.0f frames/s%s, %.1f KB a frame\n", a.len, a.wid, r.rows, r.columns, r.zoom, frames / time, (i < 2) ? "" : " including stepping", (double)bytes / frames / 1024);
+        render_free(&r);
+        grid_free(&a);
+    }
+}
+
+//Times stepping a random 4096 by 4096 board on its own and while exporting every generation as a raw stream to /dev/null, with as many encoders as batch would start alongside the pool, to show how much exporting frames slows the stepping thread down.
+void time_export(Thread_pool *pool){
+    int generations = 100, size = 4096;
+    double times[2];
+    Grid_info a;
+    Exporter e;
+    
+    for(int i=0; i<2; i++){
+        if (grid_alloc(&a, size, size) != 0) {
+            printf("Out of memory!\n");
+            return;
+        }
+        a.pool = pool;
+        srand(7);
+        randomise(&a);
+        if (i == 1 && export_start(&e, &a, "/dev/null", 1, export_threads(pool->threads)) != 0) {
+            printf("Could not start exporting frames!\n");
+            grid_free(&a);
+            return;
+        }
+        double start = now_seconds();
+        for(int j=0; j<generations; j++){
+            next(&a);
+            advance(&a);
+            if (i == 1) {
+                export_frame(&e, &a);
+            }
+        }
+        if (i == 1) {
+            export_finish(&e);
+        }
+        times[i] = now_seconds() - start;
+        grid_free(&a);
+    }
+    printf("Export: %dx%d board, %d generations in %.3f s on their own and %.3f s exporting every one on %d encoders (%.0f frames/s, %.2fx)\n", size, size, generations, times[0], times[1], export_threads(pool->threads), generations / times[1], times[1] / times[0]);
+}
+
+//Times next() on 1, 2, 4... threads up to the thread count and prints the speed up over one thread. If advancing is set, each generation is also copied back into grid so that quiet tiles get skipped as they would in a real run.
+int time_threads(Grid_info *a, int generations, int advancing){
+    double cells = (double)a->len * a->wid * generations, one_thread = 0, start, time;
+    int most = thread_count();
+    Thread_pool *single = a->pool;
+    
+    for(int t=1; t<=most; t = (t < most && t*2 > most) ? most : t*2){
+        a->pool = pool_create(t);
+        if (a->pool == NULL) {
+            printf("Could not start the worker threads!\n");
+            return -1;
+        }
+        a->tiles_known = 0;
+        start = now_seconds();
+        for(int j=0; j<generations; j++){
+            next(a);
+            if (advancing) {
+                advance(a);
+            }
+        }
+        time = now_seconds() - start;
+        if (t == 1) {
+            one_thread = time;
+        }
+        printf("  %3d threads   %8.3f s  %10.3e cell updates/s  (%.2fx)\n", a->pool->threads, time, cells / time, one_thread / time);
+        pool_destroy(a->pool);
+    }
+    a->pool = single;
+    return 0;
+}
+
+//This function checks that each row kernel this processor can run gives exactly the same boards as the cell-by-cell kernel, on a set of board sizes that cover the awkward cases (widths either side of a whole word, rows too short for a full vector, boards with fewer rows than threads, and the smallest boards where neighbours on both sides are the same cell), plus a sparse board where most tiles are skipped. The kernels are checked split over three threads so the tile edges and work stealing are covered too. It then times them all on a large random board, and times the chosen kernel on 1, 2, 4... threads up to the thread count, on the dense board and on a sparse board of scattered soups. Usage: game bench [size] [generations]
+int benchmark(int argc, char *argv[]){
+    int size = (argc > 2) ? atoi(argv[2]) : 1024;
+    int generations = (argc > 3) ? atoi(argv[3]) : 20;
+    int sizes[][2] = {{2,2}, {3,5}, {10,10}, {17,63}, {31,64}, {40,65}, {64,130}, {100,200}, {12,777}, {9,1100}, {5,4096}, {300,1200}};
+    int count = (int)(sizeof(sizes) / sizeof(sizes[0])), failed;
+    Row_kernel kernels[3] = {rule_kernels[life_rule.kind][0], NULL, NULL};
+    const char *names[3] = {"swar", "avx2", "avx512"};
+    Row_kernel chosen = step_row;
+    Thread_pool *pool = pool_create(3);
+    Grid_info a, b;
+    
+    if (size < 2 || generations < 1 || pool == NULL) {
+        printf("Usage: game bench [size] [generations]\n");
+        return -1;
+    }
+#ifdef HAVE_X86_KERNELS
+    if (__builtin_cpu_supports("avx2")) {
+        kernels[1] = rule_kernels[life_rule.kind][1];
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        kernels[2] = rule_kernels[life_rule.kind][2];
+    }
+#endif
+    printf("Kernel picked for this processor: %s, rule %s\n", kernel_name, life_rule.name);
+    
+    //Correctness check - each kernel is run side by side with the cell-by-cell one. The last board size is a sparse one.
+    for(int n=0; n<3; n++){
+        if (kernels[n] == NULL) {
+            continue;
+        }
+        step_row = kernels[n];
+        srand(1);
+        for(int i=0; i<count; i++){
+            if (grid_alloc(&a, sizes[i][0], sizes[i][1]) != 0 || grid_alloc(&b, sizes[i][0], sizes[i][1]) != 0) {
+                printf("Out of memory!\n");
+                return -1;
+            }
+            if (i + 1 < count) {
+                randomise(&a);
+            }
+            else{
+                scatter_soups(&a, 3, 30);
+            }
+            b.pool = pool;
+            failed = check_kernel(&a, &b, (i + 1 < count) ? 50 : 200);
+            if (failed != 0) {
+                printf("The %s kernel disagrees with the cell-by-cell kernel on a %dx%d board at generation %d.\n", names[n], a.len, a.wid, failed);
+                return -1;
+            }
+            grid_free(&a);
+            grid_free(&b);
+        }
+        printf("The %s kernel matches the cell-by-cell kernel on %d board sizes.\n", names[n], count);
+    }
+    if (check_rules(pool, size, generations) != 0) {
+        return -1;
+    }
+    if (check_cycles(pool) != 0) {
+        return -1;
+    }
+    if (check_stats(pool, size, generations) != 0) {
+        return -1;
+    }
+    if (check_soups(pool) != 0) {
+        return -1;
+    }
+    if (check_lockstep() != 0) {
+        return -1;
+    }
+    uint64_t hashlife_failed = check_hashlife(pool);
+    if (hashlife_failed != 0) {
+        printf("HashLife disagrees with next() at generation %llu.\n", (unsigned long long)hashlife_failed);
+        return -1;
+    }
+    uint64_t sparse_failed = check_sparse(pool);
+    if (sparse_failed != 0) {
+        printf("The sparse plane disagrees with next() at generation %llu.\n", (unsigned long long)sparse_failed);
+        return -1;
+    }
+    if (check_packed(pool) != 0) {
+        return -1;
+    }
+    if (check_rle() != 0) {
+        return -1;
+    }
+    time_render(pool);
+    time_export(pool);
+    pool_destroy(pool);
+    
+    //Throughput on one large board.
+    if (grid_alloc(&a, size, size) != 0) {
+        printf("Out of memory!\n");
+        return -1;
+    }
+    randomise(&a);
+    double cells = (double)size * size * generations, start, scalar_time, time;
+    
+    start = now_seconds();
+    for(int j=0; j<generations; j++){
+        next_scalar(&a);
+    }
+    scalar_time = now_seconds() - start;
+    printf("%dx%d board, %d generations:\n", size, size, generations);
+    printf("  cell-by-cell: %8.3f s  %10.3e cell updates/s\n", scalar_time, cells / scalar_time);
+    
+    for(int n=0; n<3; n++){
+        if (kernels[n] == NULL) {
+            continue;
+        }
+        step_row = kernels[n];
+        start = now_seconds();
+        for(int j=0; j<generations; j++){
+            next(&a);
+        }
+        time = now_seconds() - start;
+        printf("  %-12s  %8.3f s  %10.3e cell updates/s  (%.1fx)\n", names[n], time, cells / time, scalar_time / time);
+    }
+    step_row = chosen;
+    
+    //Scaling with the number of threads, using the kernel picked for this processor, on the random board and then on a board four times the size with a few soups scattered over it.
+    printf("%s kernel on more threads, random board:\n", kernel_name);
+    if (time_threads(&a, generations, 0) != 0) {
+        return -1;
+    }
+    if (grid_resize(&a, 2*size, 2*size) != 0) {
+        printf("Out of memory!\n");
+        return -1;
+    }
+    scatter_soups(&a, 16, 64);
+    printf("%s kernel on more threads, sparse %dx%d board:\n", kernel_name, 2*size, 2*size);
+    if (time_threads(&a, generations, 1) != 0) {
+        return -1;
+    }
+    grid_free(&a);
+    return 0;
 }
 
 //========================= Results of the Program ===============================================